@@ -14,12 +14,16 @@
 #include "driver/spi_master.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_rom_sys.h"
 
 static const char *TAG = "DEV";
 
 static spi_device_handle_t spi_handle = NULL;
+static SemaphoreHandle_t busy_sem = NULL;
+static UBYTE isr_service_owned = 0;
 
 /**
  * GPIO
@@ -44,6 +48,60 @@ UBYTE DEV_Digital_Read(UWORD Pin)
     return gpio_get_level((gpio_num_t)Pin);
 }
 
+/**
+ * BUSY pin falling edge, the panel has finished its current operation
+ **/
+static void IRAM_ATTR DEV_Busy_ISR(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(busy_sem, &woken);
+    if (woken)
+    {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/******************************************************************************
+function:	Wait for the BUSY pin to go LOW
+parameter:
+    Timeout_ms : Maximum time to wait, DEV_WAIT_FOREVER to block
+Info:
+    Returns 0 once the pin is low, 1 on timeout
+******************************************************************************/
+UBYTE DEV_Busy_Wait(UDOUBLE Timeout_ms)
+{
+    TickType_t ticks = (Timeout_ms == DEV_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(Timeout_ms);
+    TickType_t start = xTaskGetTickCount();
+
+    if (busy_sem == NULL)
+    {
+        // No edge interrupt available, fall back to polling
+        while (DEV_Digital_Read(EPD_BUSY_PIN) != 0)
+        {
+            if (ticks != portMAX_DELAY && xTaskGetTickCount() - start >= ticks)
+            {
+                return 1;
+            }
+            DEV_Delay_ms(1);
+        }
+        return 0;
+    }
+
+    // Drop an edge left over from an earlier command, then re-check the
+    // level after each wake in case the edge came before we started waiting
+    xSemaphoreTake(busy_sem, 0);
+    while (DEV_Digital_Read(EPD_BUSY_PIN) != 0)
+    {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (ticks != portMAX_DELAY && elapsed >= ticks)
+        {
+            return 1;
+        }
+        xSemaphoreTake(busy_sem, (ticks == portMAX_DELAY) ? portMAX_DELAY : ticks - elapsed);
+    }
+    return 0;
+}
+
 /**
  * SPI
  **/
@@ -56,18 +114,20 @@ void DEV_SPI_WriteByte(uint8_t Value)
     spi_device_transmit(spi_handle, &trans);
 }
 
-void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len)
+void DEV_SPI_Write_nByte(const uint8_t *pData, uint32_t Len)
 {
-    if (Len == 0)
+    // One DMA transaction per chunk, bounded by the bus max_transfer_sz
+    while (Len > 0)
     {
-        return;
+        uint32_t Chunk = (Len > DEV_SPI_MAX_TRANSFER) ? DEV_SPI_MAX_TRANSFER : Len;
+        spi_transaction_t trans = {
+            .length = Chunk * 8,
+            .tx_buffer = pData,
+        };
+        spi_device_transmit(spi_handle, &trans);
+        pData += Chunk;
+        Len -= Chunk;
     }
-
-    spi_transaction_t trans = {
-        .length = Len * 8,
-        .tx_buffer = pData,
-    };
-    spi_device_transmit(spi_handle, &trans);
 }
 
 /**
@@ -119,6 +179,64 @@ static void DEV_GPIO_Init(const epd_pin_config_t *pin_config)
     DEV_Digital_Write(EPD_CS_PIN, 1);
 }
 
+/******************************************************************************
+function:	Signal BUSY releases through a GPIO edge interrupt
+parameter:
+Info:
+    On failure DEV_Busy_Wait falls back to polling the pin
+******************************************************************************/
+static void DEV_Busy_Intr_Init(void)
+{
+    busy_sem = xSemaphoreCreateBinary();
+    if (busy_sem == NULL)
+    {
+        ESP_LOGW(TAG, "BUSY semaphore allocation failed, polling instead");
+        return;
+    }
+
+    // The application may already own the shared GPIO ISR service
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret == ESP_OK)
+    {
+        isr_service_owned = 1;
+    }
+    else if (ret != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGW(TAG, "GPIO ISR service install failed, polling BUSY instead");
+        vSemaphoreDelete(busy_sem);
+        busy_sem = NULL;
+        return;
+    }
+
+    gpio_set_intr_type((gpio_num_t)EPD_BUSY_PIN, GPIO_INTR_NEGEDGE);
+    if (gpio_isr_handler_add((gpio_num_t)EPD_BUSY_PIN, DEV_Busy_ISR, NULL) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "BUSY interrupt setup failed, polling instead");
+        gpio_set_intr_type((gpio_num_t)EPD_BUSY_PIN, GPIO_INTR_DISABLE);
+        vSemaphoreDelete(busy_sem);
+        busy_sem = NULL;
+        return;
+    }
+    gpio_intr_enable((gpio_num_t)EPD_BUSY_PIN);
+}
+
+static void DEV_Busy_Intr_Exit(void)
+{
+    if (busy_sem == NULL)
+    {
+        return;
+    }
+    gpio_isr_handler_remove((gpio_num_t)EPD_BUSY_PIN);
+    gpio_set_intr_type((gpio_num_t)EPD_BUSY_PIN, GPIO_INTR_DISABLE);
+    if (isr_service_owned)
+    {
+        gpio_uninstall_isr_service();
+        isr_service_owned = 0;
+    }
+    vSemaphoreDelete(busy_sem);
+    busy_sem = NULL;
+}
+
 /******************************************************************************
 function:	Module Initialize, the library and initialize the pins, SPI protocol
 parameter:  pin_config - Pin configuration structure from application
@@ -135,6 +253,7 @@ UBYTE DEV_Module_Init(const epd_pin_config_t *pin_config)
 
     // GPIO Config
     DEV_GPIO_Init(pin_config);
+    DEV_Busy_Intr_Init();
 
     // SPI Config
     spi_bus_config_t bus_cfg = {
@@ -143,13 +262,14 @@ UBYTE DEV_Module_Init(const epd_pin_config_t *pin_config)
         .sclk_io_num = EPD_CLK_PIN,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = 4000,
+        .max_transfer_sz = DEV_SPI_MAX_TRANSFER,
     };
 
     esp_err_t ret = spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_CH_AUTO);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "SPI bus init failed");
+        DEV_Busy_Intr_Exit();
         return 1;
     }
 
@@ -166,6 +286,7 @@ UBYTE DEV_Module_Init(const epd_pin_config_t *pin_config)
     {
         ESP_LOGE(TAG, "SPI device add failed");
         spi_bus_free(SPI2_HOST);
+        DEV_Busy_Intr_Exit();
         return 1;
     }
 
@@ -186,4 +307,5 @@ void DEV_Module_Exit(void)
         spi_handle = NULL;
     }
     spi_bus_free(SPI2_HOST);
+    DEV_Busy_Intr_Exit();
 }
@@ -11,9 +11,207 @@
  ******************************************************************************/
 #include "EPD_2in13.h"
 #include "Debug.h"
+#include "Frame_Ops.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <stdlib.h>
+#include <string.h>
 
 static const char *TAG = "EPD";
 
+// Bytes per panel row in controller RAM
+#define EPD_2IN13_LINE_BYTES ((EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1))
+// Bytes per row of a landscape frame, EPD_2IN13_HEIGHT pixels wide
+#define EPD_2IN13_LANDSCAPE_LINE_BYTES ((EPD_2IN13_HEIGHT % 8 == 0) ? (EPD_2IN13_HEIGHT / 8) : (EPD_2IN13_HEIGHT / 8 + 1))
+// Bytes per row of a 2bpp grayscale image
+#define EPD_2IN13_GRAY_LINE_BYTES ((EPD_2IN13_WIDTH % 4 == 0) ? (EPD_2IN13_WIDTH / 4) : (EPD_2IN13_WIDTH / 4 + 1))
+// Staging buffer for windowed uploads and fills, flushed in one transfer
+#define EPD_2IN13_BOUNCE_SIZE 512
+
+static DMA_ATTR UBYTE s_bounce[EPD_2IN13_BOUNCE_SIZE];
+static EPD_2IN13_TIMING s_timing;
+static UDOUBLE s_upload_us;
+static UDOUBLE s_busy_timeout_ms = EPD_2IN13_BUSY_TIMEOUT_MS;
+
+// Setup cost of one extra RAM window, in bytes of pixel data
+#define EPD_2IN13_WINDOW_COST 64
+
+/**
+ * RAM window in byte columns and rows, inclusive
+ **/
+typedef struct
+{
+    UWORD XbStart;
+    UWORD XbEnd;
+    UWORD Ystart;
+    UWORD Yend;
+} EPD_2IN13_WINDOW;
+
+static inline UDOUBLE EPD_2IN13_WindowBytes(const EPD_2IN13_WINDOW *W)
+{
+    return (UDOUBLE)(W->XbEnd - W->XbStart + 1) * (W->Yend - W->Ystart + 1);
+}
+
+static inline UBYTE EPD_2IN13_ReverseByte(UBYTE b)
+{
+    b = (UBYTE)((b >> 4) | (b << 4));
+    b = (UBYTE)(((b >> 2) & 0x33) | ((b & 0x33) << 2));
+    return (UBYTE)(((b >> 1) & 0x55) | ((b & 0x55) << 1));
+}
+
+/**
+ * Last values written to the SSD1680 configuration registers
+ **/
+typedef struct
+{
+    UBYTE Reg;
+    UBYTE Len;
+    UBYTE Valid;
+    UBYTE Data[4];
+} EPD_2IN13_REG;
+
+static EPD_2IN13_REG s_regs[] = {
+    {.Reg = 0x01}, // Driver output control
+    {.Reg = 0x03}, // Gate driving voltage
+    {.Reg = 0x04}, // Source driving voltage
+    {.Reg = 0x11}, // Data entry mode
+    {.Reg = 0x21}, // Display update control 1
+    {.Reg = 0x22}, // Display update control 2
+    {.Reg = 0x2C}, // VCOM
+    {.Reg = 0x3C}, // Border waveform
+    {.Reg = 0x3F}, // End option
+    {.Reg = 0x44}, // RAM X window
+    {.Reg = 0x45}, // RAM Y window
+    {.Reg = 0x4E}, // RAM X address counter
+    {.Reg = 0x4F}, // RAM Y address counter
+};
+static UBYTE s_partial_mode; // Partial-refresh registers set since the last reset
+static const UBYTE *s_lut_loaded; // Waveform in the LUT register, NULL for OTP
+
+// Copy of the B/W RAM contents for automatic partial refresh
+static UBYTE *s_shadow;
+static UBYTE s_shadow_valid;
+
+// Orientation applied on the way to the controller RAM
+static EPD_2IN13_ORIENTATION s_orientation = EPD_2IN13_ORIENT_NORMAL;
+
+// Frame buffer layout, landscape frames are converted into s_panel
+static EPD_2IN13_LAYOUT s_layout = EPD_2IN13_LAYOUT_PORTRAIT;
+static UBYTE *s_panel;
+static UBYTE *EPD_2IN13_PanelFrame(UBYTE *Image);
+
+/**
+ * Asynchronous refresh state
+ **/
+#define EPD_2IN13_ASYNC_IDLE_BIT (1 << 0)
+#define EPD_2IN13_ASYNC_STACK 3072
+#define EPD_2IN13_ASYNC_PRIO 5
+
+typedef struct
+{
+    UBYTE Mode;    // Display Update Control 2 sequence
+    UBYTE Partial; // Needs the partial-refresh register setup
+    EPD_2IN13_DONE_CB Cb;
+    void *Ctx;
+} EPD_2IN13_JOB;
+
+static TaskHandle_t s_async_task;
+static SemaphoreHandle_t s_async_lock;  // Guards the controller and job state
+static SemaphoreHandle_t s_async_slot;  // Free while no job is pending
+static EventGroupHandle_t s_async_events;
+static EPD_2IN13_JOB s_async_running;
+static EPD_2IN13_JOB s_async_pending;
+static UBYTE s_async_has_pending;
+static UBYTE *s_async_frame; // Copy of the pending image
+
+/******************************************************************************
+function :	Create the controller lock and idle flag on first use
+parameter:
+******************************************************************************/
+static UBYTE EPD_2IN13_LockBegin(void)
+{
+    if (s_async_lock == NULL)
+    {
+        s_async_lock = xSemaphoreCreateMutex();
+    }
+    if (s_async_events == NULL)
+    {
+        s_async_events = xEventGroupCreate();
+        if (s_async_events)
+        {
+            xEventGroupSetBits(s_async_events, EPD_2IN13_ASYNC_IDLE_BIT);
+        }
+    }
+    if (!s_async_lock || !s_async_events)
+    {
+        ESP_LOGE(TAG, "Failed to allocate the controller lock");
+        return 1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function :	Take the controller for a synchronous call
+parameter:
+Info:
+    Waits out queued asynchronous refreshes and keeps the lock, so no new
+    one starts until EPD_2IN13_Release. Fails on the driver task, where the
+    refresh it would wait for is the one running the callback.
+******************************************************************************/
+static UBYTE EPD_2IN13_Claim(void)
+{
+    if (EPD_2IN13_LockBegin() != 0)
+    {
+        return 1;
+    }
+    if (s_async_task != NULL && xTaskGetCurrentTaskHandle() == s_async_task)
+    {
+        ESP_LOGE(TAG, "Synchronous display calls are not allowed in a refresh callback");
+        return 1;
+    }
+    for (;;)
+    {
+        xSemaphoreTake(s_async_lock, portMAX_DELAY);
+        if (xEventGroupGetBits(s_async_events) & EPD_2IN13_ASYNC_IDLE_BIT)
+        {
+            return 0;
+        }
+        xSemaphoreGive(s_async_lock);
+        xEventGroupWaitBits(s_async_events, EPD_2IN13_ASYNC_IDLE_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+}
+
+/******************************************************************************
+function :	Give the controller back after EPD_2IN13_Claim
+parameter:
+    Status : Result of the synchronous call, passed through
+******************************************************************************/
+static UBYTE EPD_2IN13_Release(UBYTE Status)
+{
+    xSemaphoreGive(s_async_lock);
+    return Status;
+}
+
+/******************************************************************************
+function :	Forget the cached register values
+parameter:
+Info:
+    Called whenever the controller drops back to its reset defaults
+******************************************************************************/
+static void EPD_2IN13_InvalidateRegs(void)
+{
+    for (UWORD i = 0; i < sizeof(s_regs) / sizeof(s_regs[0]); i++)
+    {
+        s_regs[i].Valid = 0;
+    }
+    s_partial_mode = 0;
+    s_lut_loaded = NULL;
+}
+
 /******************************************************************************
 function :	Software reset
 parameter:
@@ -26,6 +224,7 @@ static void EPD_2IN13_Reset(void)
     DEV_Delay_ms(2);
     DEV_Digital_Write(EPD_RST_PIN, 1);
     DEV_Delay_ms(20);
+    EPD_2IN13_InvalidateRegs();
 }
 
 /******************************************************************************
@@ -55,20 +254,52 @@ static void EPD_2IN13_SendData(UBYTE Data)
 }
 
 /******************************************************************************
-function :	Wait until the busy_pin goes LOW
+function :	send a block of data as bulk SPI transfers
 parameter:
+    Data : Write data
+    Len  : Number of bytes
 ******************************************************************************/
-static void EPD_2IN13_ReadBusy(void)
+static void EPD_2IN13_SendDataBuffer(const UBYTE *Data, UDOUBLE Len)
 {
-    Debug("e-Paper busy\r\n");
-    while (1)
-    { //=1 BUSY
-        if (DEV_Digital_Read(EPD_BUSY_PIN) == 0)
+    DEV_Digital_Write(EPD_DC_PIN, 1);
+    DEV_Digital_Write(EPD_CS_PIN, 0);
+    DEV_SPI_Write_nByte(Data, Len);
+    DEV_Digital_Write(EPD_CS_PIN, 1);
+}
+
+/******************************************************************************
+function :	Write a register, skipped when it already holds the same value
+parameter:
+    Reg  : Command register
+    Data : Parameter bytes
+    Len  : Number of parameter bytes
+******************************************************************************/
+static void EPD_2IN13_SetReg(UBYTE Reg, const UBYTE *Data, UBYTE Len)
+{
+    EPD_2IN13_REG *Cached = NULL;
+    for (UWORD i = 0; i < sizeof(s_regs) / sizeof(s_regs[0]); i++)
+    {
+        if (s_regs[i].Reg == Reg)
+        {
+            Cached = &s_regs[i];
             break;
-        DEV_Delay_ms(10);
+        }
+    }
+
+    if (Cached && Cached->Valid && Cached->Len == Len && memcmp(Cached->Data, Data, Len) == 0)
+    {
+        return;
+    }
+
+    EPD_2IN13_SendCommand(Reg);
+    EPD_2IN13_SendDataBuffer(Data, Len);
+
+    if (Cached && Len <= sizeof(Cached->Data))
+    {
+        memcpy(Cached->Data, Data, Len);
+        Cached->Len = Len;
+        Cached->Valid = 1;
     }
-    DEV_Delay_ms(10);
-    Debug("e-Paper busy release\r\n");
 }
 
 /******************************************************************************
@@ -81,15 +312,11 @@ parameter:
 ******************************************************************************/
 static void EPD_2IN13_SetWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
 {
-    EPD_2IN13_SendCommand(0x44); // SET_RAM_X_ADDRESS_START_END_POSITION
-    EPD_2IN13_SendData((Xstart >> 3) & 0xFF);
-    EPD_2IN13_SendData((Xend >> 3) & 0xFF);
+    UBYTE X[2] = {(Xstart >> 3) & 0xFF, (Xend >> 3) & 0xFF};
+    EPD_2IN13_SetReg(0x44, X, sizeof(X)); // SET_RAM_X_ADDRESS_START_END_POSITION
 
-    EPD_2IN13_SendCommand(0x45); // SET_RAM_Y_ADDRESS_START_END_POSITION
-    EPD_2IN13_SendData(Ystart & 0xFF);
-    EPD_2IN13_SendData((Ystart >> 8) & 0xFF);
-    EPD_2IN13_SendData(Yend & 0xFF);
-    EPD_2IN13_SendData((Yend >> 8) & 0xFF);
+    UBYTE Y[4] = {Ystart & 0xFF, (Ystart >> 8) & 0xFF, Yend & 0xFF, (Yend >> 8) & 0xFF};
+    EPD_2IN13_SetReg(0x45, Y, sizeof(Y)); // SET_RAM_Y_ADDRESS_START_END_POSITION
 }
 
 /******************************************************************************
@@ -100,323 +327,1643 @@ parameter:
 ******************************************************************************/
 static void EPD_2IN13_SetCursor(UWORD Xstart, UWORD Ystart)
 {
-    EPD_2IN13_SendCommand(0x4E); // SET_RAM_X_ADDRESS_COUNTER
-    EPD_2IN13_SendData(Xstart & 0xFF);
+    UBYTE X[1] = {(Xstart >> 3) & 0xFF};
+    EPD_2IN13_SetReg(0x4E, X, sizeof(X)); // SET_RAM_X_ADDRESS_COUNTER
 
-    EPD_2IN13_SendCommand(0x4F); // SET_RAM_Y_ADDRESS_COUNTER
-    EPD_2IN13_SendData(Ystart & 0xFF);
-    EPD_2IN13_SendData((Ystart >> 8) & 0xFF);
+    UBYTE Y[2] = {Ystart & 0xFF, (Ystart >> 8) & 0xFF};
+    EPD_2IN13_SetReg(0x4F, Y, sizeof(Y)); // SET_RAM_Y_ADDRESS_COUNTER
 }
 
 /******************************************************************************
-function :	Turn On Display
+function :	Data entry mode for the current orientation
 parameter:
+Info:
+    X always increments, Y decrements for a vertical mirror
 ******************************************************************************/
-static void EPD_2IN13_TurnOnDisplay(void)
+static inline UBYTE EPD_2IN13_EntryMode(void)
 {
-    EPD_2IN13_SendCommand(0x22); // Display Update Control
-    EPD_2IN13_SendData(0xf7);
-    EPD_2IN13_SendCommand(0x20); // Activate Display Update Sequence
-    EPD_2IN13_ReadBusy();
+    return (s_orientation & EPD_2IN13_ORIENT_MIRROR_Y) ? 0x01 : 0x03;
 }
 
-static void EPD_2IN13_TurnOnDisplay_Fast(void)
+/******************************************************************************
+function :	Set data entry mode, window and cursor for a block of frame rows
+parameter:
+    XbStart : First RAM byte column
+    XbEnd   : Last RAM byte column
+    Ystart  : First frame row
+    Yend    : Last frame row
+Info:
+    With a vertical mirror the window runs from the bottom RAM row up, so
+    the rows are still sent in frame order.
+******************************************************************************/
+static void EPD_2IN13_SetRamArea(UWORD XbStart, UWORD XbEnd, UWORD Ystart, UWORD Yend)
 {
-    EPD_2IN13_SendCommand(0x22); // Display Update Control
-    EPD_2IN13_SendData(0xc7);    // fast:0x0c, quality:0x0f, 0xcf
-    EPD_2IN13_SendCommand(0x20); // Activate Display Update Sequence
-    EPD_2IN13_ReadBusy();
+    UBYTE EntryMode = EPD_2IN13_EntryMode();
+    EPD_2IN13_SetReg(0x11, &EntryMode, 1); // data entry mode
+    if (s_orientation & EPD_2IN13_ORIENT_MIRROR_Y)
+    {
+        Ystart = EPD_2IN13_HEIGHT - 1 - Ystart;
+        Yend = EPD_2IN13_HEIGHT - 1 - Yend;
+    }
+    EPD_2IN13_SetWindows(XbStart * 8, Ystart, XbEnd * 8 + 7, Yend);
+    EPD_2IN13_SetCursor(XbStart * 8, Ystart);
 }
 
-static void EPD_2IN13_TurnOnDisplay_Partial(void)
+/******************************************************************************
+function :	Mirror one RAM row horizontally
+parameter:
+    Src : EPD_2IN13_LINE_BYTES bytes
+    Dst : EPD_2IN13_LINE_BYTES bytes
+Info:
+    Pixel x goes to EPD_2IN13_WIDTH - 1 - x. The bytes are reversed and
+    bit-reversed, then shifted left over the padding bits at the row end.
+******************************************************************************/
+static void EPD_2IN13_MirrorRow(const UBYTE *Src, UBYTE *Dst)
 {
-    EPD_2IN13_SendCommand(0x22); // Display Update Control
-    EPD_2IN13_SendData(0xff);    // fast:0x0c, quality:0x0f, 0xcf
-    EPD_2IN13_SendCommand(0x20); // Activate Display Update Sequence
-    EPD_2IN13_ReadBusy();
+    const UBYTE Shift = EPD_2IN13_LINE_BYTES * 8 - EPD_2IN13_WIDTH;
+    UBYTE Cur = EPD_2IN13_ReverseByte(Src[EPD_2IN13_LINE_BYTES - 1]);
+    for (UWORD i = 0; i < EPD_2IN13_LINE_BYTES; i++)
+    {
+        UBYTE Next = (i + 1 < EPD_2IN13_LINE_BYTES) ? EPD_2IN13_ReverseByte(Src[EPD_2IN13_LINE_BYTES - 2 - i]) : 0xFF;
+        Dst[i] = (UBYTE)((Cur << Shift) | (Next >> (8 - Shift)));
+        Cur = Next;
+    }
 }
 
 /******************************************************************************
-function :	Initialize the e-Paper register
+function :	Forget the cursor, the address counters move as RAM is written
 parameter:
 ******************************************************************************/
-void EPD_2IN13_Init(void)
+static void EPD_2IN13_InvalidateCursor(void)
 {
-    ESP_LOGI(TAG, "Initializing e-Paper display...");
-    EPD_2IN13_Reset();
-
-    EPD_2IN13_ReadBusy();
-    EPD_2IN13_SendCommand(0x12); // SWRESET
-    EPD_2IN13_ReadBusy();
-
-    EPD_2IN13_SendCommand(0x01); // Driver output control
-    EPD_2IN13_SendData(0xF9);
-    EPD_2IN13_SendData(0x00);
-    EPD_2IN13_SendData(0x00);
-
-    EPD_2IN13_SendCommand(0x11); // data entry mode
-    EPD_2IN13_SendData(0x03);
-
-    EPD_2IN13_SetWindows(0, 0, EPD_2IN13_WIDTH - 1, EPD_2IN13_HEIGHT - 1);
-    EPD_2IN13_SetCursor(0, 0);
-
-    EPD_2IN13_SendCommand(0x3C); // BorderWavefrom
-    EPD_2IN13_SendData(0x05);
-
-    EPD_2IN13_SendCommand(0x21); //  Display update control
-    EPD_2IN13_SendData(0x00);
-    EPD_2IN13_SendData(0x80);
-
-    EPD_2IN13_SendCommand(0x18); // Read built-in temperature sensor
-    EPD_2IN13_SendData(0x80);
-    EPD_2IN13_ReadBusy();
-    ESP_LOGI(TAG, "e-Paper display initialized");
+    for (UWORD i = 0; i < sizeof(s_regs) / sizeof(s_regs[0]); i++)
+    {
+        if (s_regs[i].Reg == 0x4E || s_regs[i].Reg == 0x4F)
+        {
+            s_regs[i].Valid = 0;
+        }
+    }
 }
 
-void EPD_2IN13_Init_Fast(void)
+/******************************************************************************
+function :	Set the RAM window and write rows of image data into it
+parameter:
+    Reg     : RAM write command, 0x24 (B/W) or 0x26 (RED)
+    Rows    : Image rows from Ystart on, EPD_2IN13_LINE_BYTES each
+    XbStart : First byte column of the window
+    XbEnd   : Last byte column of the window
+    Ystart  : First row of the window
+    Yend    : Last row of the window
+******************************************************************************/
+static void EPD_2IN13_WriteRows(UBYTE Reg, const UBYTE *Rows, UWORD XbStart, UWORD XbEnd, UWORD Ystart, UWORD Yend)
 {
-    ESP_LOGI(TAG, "Initializing e-Paper display (fast mode)...");
-    EPD_2IN13_Reset();
-
-    EPD_2IN13_SendCommand(0x12); // SWRESET
-    EPD_2IN13_ReadBusy();
-
-    EPD_2IN13_SendCommand(0x18); // Read built-in temperature sensor
-    EPD_2IN13_SendData(0x80);
-
-    EPD_2IN13_SendCommand(0x11); // data entry mode
-    EPD_2IN13_SendData(0x03);
-
-    EPD_2IN13_SetWindows(0, 0, EPD_2IN13_WIDTH - 1, EPD_2IN13_HEIGHT - 1);
-    EPD_2IN13_SetCursor(0, 0);
+    UBYTE MirrorX = s_orientation & EPD_2IN13_ORIENT_MIRROR_X;
+    if (MirrorX)
+    {
+        // Mirrored pixels don't move by whole bytes, send whole rows
+        XbStart = 0;
+        XbEnd = EPD_2IN13_LINE_BYTES - 1;
+    }
+    UWORD RowBytes = XbEnd - XbStart + 1;
+    int64_t Start = esp_timer_get_time();
 
-    EPD_2IN13_SendCommand(0x22); // Load temperature value
-    EPD_2IN13_SendData(0xB1);
-    EPD_2IN13_SendCommand(0x20);
-    EPD_2IN13_ReadBusy();
+    EPD_2IN13_SetRamArea(XbStart, XbEnd, Ystart, Yend);
+    EPD_2IN13_SendCommand(Reg);
+    if (RowBytes == EPD_2IN13_LINE_BYTES && !MirrorX)
+    {
+        // Full-width rows are contiguous, send them in one go
+        EPD_2IN13_SendDataBuffer(Rows, (UDOUBLE)RowBytes * (Yend - Ystart + 1));
+    }
+    else
+    {
+        // Gather the window rows into the bounce buffer
+        UDOUBLE Fill = 0;
+        DEV_Digital_Write(EPD_DC_PIN, 1);
+        DEV_Digital_Write(EPD_CS_PIN, 0);
+        for (UWORD row = 0; row <= Yend - Ystart; row++)
+        {
+            if (Fill + RowBytes > EPD_2IN13_BOUNCE_SIZE)
+            {
+                DEV_SPI_Write_nByte(s_bounce, Fill);
+                Fill = 0;
+            }
+            if (MirrorX)
+            {
+                EPD_2IN13_MirrorRow(&Rows[row * EPD_2IN13_LINE_BYTES], &s_bounce[Fill]);
+            }
+            else
+            {
+                memcpy(&s_bounce[Fill], &Rows[row * EPD_2IN13_LINE_BYTES + XbStart], RowBytes);
+            }
+            Fill += RowBytes;
+        }
+        DEV_SPI_Write_nByte(s_bounce, Fill);
+        DEV_Digital_Write(EPD_CS_PIN, 1);
+    }
+    EPD_2IN13_InvalidateCursor();
+    s_upload_us += (UDOUBLE)(esp_timer_get_time() - Start);
 
-    EPD_2IN13_SendCommand(0x1A); // Write to temperature register
-    EPD_2IN13_SendData(0x64);
-    EPD_2IN13_SendData(0x00);
+    if (s_shadow && Reg == 0x24)
+    {
+        for (UWORD row = 0; row <= Yend - Ystart; row++)
+        {
+            UDOUBLE Offset = row * EPD_2IN13_LINE_BYTES + XbStart;
+            memcpy(&s_shadow[Ystart * EPD_2IN13_LINE_BYTES + Offset], &Rows[Offset], RowBytes);
+        }
+        if (RowBytes == EPD_2IN13_LINE_BYTES && Ystart == 0 && Yend == EPD_2IN13_HEIGHT - 1)
+        {
+            s_shadow_valid = 1;
+        }
+    }
+}
 
-    EPD_2IN13_SendCommand(0x22); // Load temperature value
-    EPD_2IN13_SendData(0x91);
-    EPD_2IN13_SendCommand(0x20);
-    EPD_2IN13_ReadBusy();
-    ESP_LOGI(TAG, "e-Paper display initialized (fast mode)");
+/******************************************************************************
+function :	Set the RAM window and write that part of the image buffer
+parameter:
+    Reg     : RAM write command, 0x24 (B/W) or 0x26 (RED)
+    Image   : Full frame image data
+    XbStart : First byte column of the window
+    XbEnd   : Last byte column of the window
+    Ystart  : First row of the window
+    Yend    : Last row of the window
+******************************************************************************/
+static void EPD_2IN13_WriteRam(UBYTE Reg, const UBYTE *Image, UWORD XbStart, UWORD XbEnd, UWORD Ystart, UWORD Yend)
+{
+    EPD_2IN13_WriteRows(Reg, &Image[(UDOUBLE)Ystart * EPD_2IN13_LINE_BYTES], XbStart, XbEnd, Ystart, Yend);
 }
 
 /******************************************************************************
-function :	Clear screen
+function :	Fill the whole controller RAM window with one byte value
 parameter:
+    Reg   : RAM write command, 0x24 (B/W) or 0x26 (RED)
+    Value : Fill byte
 ******************************************************************************/
-void EPD_2IN13_Clear(void)
+static void EPD_2IN13_FillRamBytes(UBYTE Reg, UBYTE Value)
 {
-    ESP_LOGI(TAG, "Clearing display to white...");
-    UWORD Width, Height;
-    Width = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    Height = EPD_2IN13_HEIGHT;
+    UDOUBLE Left = (UDOUBLE)EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT;
+    int64_t Start = esp_timer_get_time();
 
-    EPD_2IN13_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++)
+    memset(s_bounce, Value, EPD_2IN13_BOUNCE_SIZE);
+    EPD_2IN13_SetRamArea(0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    EPD_2IN13_SendCommand(Reg);
+    DEV_Digital_Write(EPD_DC_PIN, 1);
+    DEV_Digital_Write(EPD_CS_PIN, 0);
+    while (Left > 0)
     {
-        for (UWORD i = 0; i < Width; i++)
-        {
-            EPD_2IN13_SendData(0XFF);
-        }
+        UDOUBLE Chunk = (Left > EPD_2IN13_BOUNCE_SIZE) ? EPD_2IN13_BOUNCE_SIZE : Left;
+        DEV_SPI_Write_nByte(s_bounce, Chunk);
+        Left -= Chunk;
     }
+    DEV_Digital_Write(EPD_CS_PIN, 1);
+    EPD_2IN13_InvalidateCursor();
+    s_upload_us += (UDOUBLE)(esp_timer_get_time() - Start);
 
-    EPD_2IN13_TurnOnDisplay();
+    if (s_shadow && Reg == 0x24)
+    {
+        memset(s_shadow, Value, EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+        s_shadow_valid = 1;
+    }
 }
 
-void EPD_2IN13_Clear_Black(void)
+/******************************************************************************
+function :	Find the changed area between two frames
+parameter:
+    Old     : Previous frame
+    New     : Next frame
+    XbStart : First changed byte column
+    XbEnd   : Last changed byte column
+    Ystart  : First changed row
+    Yend    : Last changed row
+Info:
+    Returns 0 if the frames are identical
+******************************************************************************/
+static UBYTE EPD_2IN13_DiffBounds(const UBYTE *Old, const UBYTE *New,
+                                  UWORD *XbStart, UWORD *XbEnd, UWORD *Ystart, UWORD *Yend)
 {
-    UWORD Width, Height;
-    Width = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    Height = EPD_2IN13_HEIGHT;
+    UWORD XMin = EPD_2IN13_LINE_BYTES, XMax = 0;
+    UWORD YMin = EPD_2IN13_HEIGHT, YMax = 0;
 
-    EPD_2IN13_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++)
+    for (UWORD row = 0; row < EPD_2IN13_HEIGHT; row++)
     {
-        for (UWORD i = 0; i < Width; i++)
+        UDOUBLE first, last;
+        if (Frame_DiffRange(&Old[row * EPD_2IN13_LINE_BYTES], &New[row * EPD_2IN13_LINE_BYTES],
+                            EPD_2IN13_LINE_BYTES, &first, &last))
         {
-            EPD_2IN13_SendData(0X00);
+            XMin = (first < XMin) ? first : XMin;
+            XMax = (last > XMax) ? last : XMax;
+            YMin = (row < YMin) ? row : YMin;
+            YMax = row;
         }
     }
 
-    EPD_2IN13_TurnOnDisplay();
+    if (YMin > YMax)
+    {
+        return 0;
+    }
+    *XbStart = XMin;
+    *XbEnd = XMax;
+    *Ystart = YMin;
+    *Yend = YMax;
+    return 1;
 }
 
 /******************************************************************************
-function :	Sends the image buffer in RAM to e-Paper and displays
+function :	Wait until the busy_pin goes LOW
 parameter:
-    Image : Image data
+Info:
+    Returns 0 once released, 1 if the panel stays busy past the timeout
 ******************************************************************************/
-void EPD_2IN13_Display(UBYTE *Image)
+static UBYTE EPD_2IN13_ReadBusy(void)
 {
-    UWORD Width, Height;
-    Width = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    Height = EPD_2IN13_HEIGHT;
-
-    EPD_2IN13_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++)
+    Debug("e-Paper busy\r\n");
+    if (DEV_Busy_Wait(s_busy_timeout_ms) != 0)
     {
-        for (UWORD i = 0; i < Width; i++)
-        {
-            EPD_2IN13_SendData(Image[i + j * Width]);
-        }
+        ESP_LOGE(TAG, "e-Paper busy timeout after %lu ms", (unsigned long)s_busy_timeout_ms);
+        return 1;
     }
-
-    EPD_2IN13_TurnOnDisplay();
+    Debug("e-Paper busy release\r\n");
+    return 0;
 }
 
-void EPD_2IN13_Display_Fast(UBYTE *Image)
+/******************************************************************************
+function :	Fill the whole controller RAM with one byte value
+parameter:
+    Reg   : RAM write command, 0x24 (B/W) or 0x26 (RED)
+    Value : Fill byte
+Info:
+    All-white and all-black fills use the controller's auto-write command,
+    which fills the RAM from a single pattern byte. Other values are
+    streamed from the bounce buffer.
+******************************************************************************/
+static UBYTE EPD_2IN13_FillRamValue(UBYTE Reg, UBYTE Value)
 {
-    UWORD Width, Height;
-    Width = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    Height = EPD_2IN13_HEIGHT;
-
-    EPD_2IN13_SendCommand(0x24);
-    for (UWORD j = 0; j < Height; j++)
+    if (Value != 0x00 && Value != 0xFF)
     {
-        for (UWORD i = 0; i < Width; i++)
-        {
-            EPD_2IN13_SendData(Image[i + j * Width]);
-        }
+        EPD_2IN13_FillRamBytes(Reg, Value);
+        return 0;
     }
 
-    EPD_2IN13_TurnOnDisplay_Fast();
+    // Pattern: first cell value in bit 7, cell height and width covering the whole RAM
+    UBYTE Pattern = (Value ? 0x80 : 0x00) | 0x77;
+    int64_t Start = esp_timer_get_time();
+
+    EPD_2IN13_SetRamArea(0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    EPD_2IN13_SendCommand(Reg == 0x24 ? 0x47 : 0x46); // Auto Write B/W or RED RAM
+    EPD_2IN13_SendData(Pattern);
+    UBYTE Ret = EPD_2IN13_ReadBusy();
+    EPD_2IN13_InvalidateCursor();
+    s_upload_us += (UDOUBLE)(esp_timer_get_time() - Start);
+
+    if (s_shadow && Reg == 0x24)
+    {
+        memset(s_shadow, Value, EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+        s_shadow_valid = (Ret == 0);
+    }
+    return Ret;
 }
 
 /******************************************************************************
-function :	Refresh a base image
+function :	Start a refresh without waiting for it to finish
 parameter:
-    Image : Image data
+    Mode : Display Update Control 2 sequence
 ******************************************************************************/
-void EPD_2IN13_Display_Base(UBYTE *Image)
+static void EPD_2IN13_Activate(UBYTE Mode)
 {
-    UWORD Width, Height;
-    Width = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    Height = EPD_2IN13_HEIGHT;
+    // The RAM writes since the previous refresh make up this frame's upload
+    s_timing.Upload_us = s_upload_us;
+    s_upload_us = 0;
 
-    EPD_2IN13_SendCommand(0x24); // Write Black and White image to RAM
-    for (UWORD j = 0; j < Height; j++)
-    {
-        for (UWORD i = 0; i < Width; i++)
-        {
-            EPD_2IN13_SendData(Image[i + j * Width]);
-        }
-    }
-    EPD_2IN13_SendCommand(0x26); // Write Black and White image to RAM
-    for (UWORD j = 0; j < Height; j++)
+    // Sequences with the "load LUT" bit replace the host waveform with OTP
+    if (Mode & 0x10)
     {
-        for (UWORD i = 0; i < Width; i++)
-        {
-            EPD_2IN13_SendData(Image[i + j * Width]);
-        }
+        s_lut_loaded = NULL;
     }
-    EPD_2IN13_TurnOnDisplay();
+
+    EPD_2IN13_SetReg(0x22, &Mode, 1); // Display Update Control
+    EPD_2IN13_SendCommand(0x20);      // Activate Display Update Sequence
 }
 
 /******************************************************************************
-function :	Sends the image buffer in RAM to e-Paper and partial refresh
+function :	Turn On Display
 parameter:
-    Image : Image data
+    Mode : Display Update Control 2 sequence
 ******************************************************************************/
-void EPD_2IN13_Display_Partial(UBYTE *Image)
+static UBYTE EPD_2IN13_Update(UBYTE Mode)
 {
-    UWORD Width, Height;
-    Width = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    Height = EPD_2IN13_HEIGHT;
+    EPD_2IN13_Activate(Mode);
 
-    // Reset
-    DEV_Digital_Write(EPD_RST_PIN, 0);
-    DEV_Delay_ms(2);
-    DEV_Digital_Write(EPD_RST_PIN, 1);
+    int64_t Start = esp_timer_get_time();
+    UBYTE Ret = EPD_2IN13_ReadBusy();
+    s_timing.Busy_us = (UDOUBLE)(esp_timer_get_time() - Start);
+    return Ret;
+}
 
-    EPD_2IN13_SendCommand(0x3C); // BorderWavefrom
-    EPD_2IN13_SendData(0x80);
+static UBYTE EPD_2IN13_TurnOnDisplay(void)
+{
+    return EPD_2IN13_Update(0xf7);
+}
 
-    EPD_2IN13_SendCommand(0x01); // Driver output control
-    EPD_2IN13_SendData(0xF9);
-    EPD_2IN13_SendData(0x00);
-    EPD_2IN13_SendData(0x00);
+/******************************************************************************
+function :	Put the OTP fast waveform back after a host-loaded one
+parameter:
+Info:
+    Loads the waveform for the forced 100 degree temperature, like
+    EPD_2IN13_Init_Fast. Nothing is sent while the OTP waveform is loaded.
+******************************************************************************/
+static UBYTE EPD_2IN13_LoadFastOtp(void)
+{
+    UBYTE LoadLut = 0x91;
 
-    EPD_2IN13_SendCommand(0x11); // data entry mode
-    EPD_2IN13_SendData(0x03);
+    if (s_lut_loaded == NULL)
+    {
+        return 0;
+    }
 
-    EPD_2IN13_SetWindows(0, 0, EPD_2IN13_WIDTH - 1, EPD_2IN13_HEIGHT - 1);
-    EPD_2IN13_SetCursor(0, 0);
+    EPD_2IN13_SendCommand(0x1A); // Write to temperature register
+    EPD_2IN13_SendData(0x64);
+    EPD_2IN13_SendData(0x00);
+    EPD_2IN13_SetReg(0x22, &LoadLut, 1); // Load LUT with the written temperature
+    EPD_2IN13_SendCommand(0x20);
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return 1;
+    }
 
-    EPD_2IN13_SendCommand(0x24); // Write Black and White image to RAM
-    for (UWORD j = 0; j < Height; j++)
+    // The OTP load also replaces the driving voltages set by EPD_2IN13_LoadLut
+    for (UWORD i = 0; i < sizeof(s_regs) / sizeof(s_regs[0]); i++)
     {
-        for (UWORD i = 0; i < Width; i++)
+        UBYTE Reg = s_regs[i].Reg;
+        if (Reg == 0x03 || Reg == 0x04 || Reg == 0x2C || Reg == 0x3F)
         {
-            EPD_2IN13_SendData(Image[i + j * Width]);
+            s_regs[i].Valid = 0;
         }
     }
-    EPD_2IN13_TurnOnDisplay_Partial();
+    s_lut_loaded = NULL;
+    return 0;
 }
 
-void EPD_2IN13_Display_PartialRegion(UBYTE *Image, UWORD X, UWORD Y, UWORD Width, UWORD Height)
+static UBYTE EPD_2IN13_TurnOnDisplay_Fast(void)
 {
-    UWORD RowBytes = (EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1);
-    UWORD x_start = (X / 8) * 8;
-    UWORD x_end = ((X + Width + 7) / 8) * 8 - 1;
-    if (x_end >= EPD_2IN13_WIDTH)
+    // 0xC7 runs the waveform already loaded, which must not be a host one
+    if (EPD_2IN13_LoadFastOtp() != 0)
     {
-        x_end = EPD_2IN13_WIDTH - 1;
+        return 1;
     }
-    UWORD x_aligned_start = x_start / 8;
-    UWORD x_aligned_end = x_end / 8;
-    UWORD window_bytes = x_aligned_end - x_aligned_start + 1;
-    UWORD y_start = Y;
-    UWORD y_end = Y + Height - 1;
-    if (y_end >= EPD_2IN13_HEIGHT)
+    return EPD_2IN13_Update(0xc7); // fast:0x0c, quality:0x0f, 0xcf
+}
+
+static UBYTE EPD_2IN13_TurnOnDisplay_Partial(void)
+{
+    return EPD_2IN13_Update(0xff); // fast:0x0c, quality:0x0f, 0xcf
+}
+
+/******************************************************************************
+function :	Wake the controller into partial-refresh mode
+parameter:
+******************************************************************************/
+static void EPD_2IN13_PartialSetup(void)
+{
+    static const UBYTE Border[] = {0x80};
+    static const UBYTE DriverOutput[] = {0xF9, 0x00, 0x00};
+    UBYTE EntryMode = EPD_2IN13_EntryMode();
+
+    // Already set up by the previous partial refresh, nothing to resend
+    if (s_partial_mode)
     {
-        y_end = EPD_2IN13_HEIGHT - 1;
+        return;
     }
 
+    // Reset
     DEV_Digital_Write(EPD_RST_PIN, 0);
     DEV_Delay_ms(2);
     DEV_Digital_Write(EPD_RST_PIN, 1);
+    EPD_2IN13_InvalidateRegs();
 
-    EPD_2IN13_SendCommand(0x3C); // Border waveform
-    EPD_2IN13_SendData(0x80);
-
-    EPD_2IN13_SendCommand(0x01); // driver output control
-    EPD_2IN13_SendData(0xF9);
-    EPD_2IN13_SendData(0x00);
-    EPD_2IN13_SendData(0x00);
-
-    EPD_2IN13_SendCommand(0x11); // data entry mode
-    EPD_2IN13_SendData(0x03);
-
-    EPD_2IN13_SetWindows(x_start, y_start, x_end, y_end);
-    EPD_2IN13_SetCursor(x_start, y_start);
-
-    EPD_2IN13_SendCommand(0x24);
-    for (UWORD row = y_start; row <= y_end; row++)
-    {
-        UWORD row_offset = row * RowBytes + x_aligned_start;
-        for (UWORD col = 0; col < window_bytes; col++)
-        {
-            EPD_2IN13_SendData(Image[row_offset + col]);
-        }
-    }
-    EPD_2IN13_TurnOnDisplay_Partial();
+    EPD_2IN13_SetReg(0x3C, Border, sizeof(Border));             // BorderWavefrom
+    EPD_2IN13_SetReg(0x01, DriverOutput, sizeof(DriverOutput)); // Driver output control
+    EPD_2IN13_SetReg(0x11, &EntryMode, 1);                      // data entry mode
+    s_partial_mode = 1;
 }
 
 /******************************************************************************
-function :	Enter sleep mode
+function :	Initialize the e-Paper register
 parameter:
 ******************************************************************************/
-void EPD_2IN13_Sleep(void)
+UBYTE EPD_2IN13_Init(void)
 {
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    ESP_LOGI(TAG, "Initializing e-Paper display...");
+    EPD_2IN13_Reset();
+
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+    EPD_2IN13_SendCommand(0x12); // SWRESET
+    EPD_2IN13_InvalidateRegs();
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+
+    static const UBYTE DriverOutput[] = {0xF9, 0x00, 0x00};
+    EPD_2IN13_SetReg(0x01, DriverOutput, sizeof(DriverOutput)); // Driver output control
+
+    EPD_2IN13_SetRamArea(0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+
+    static const UBYTE Border[] = {0x05};
+    EPD_2IN13_SetReg(0x3C, Border, sizeof(Border)); // BorderWavefrom
+
+    static const UBYTE UpdateControl[] = {0x00, 0x80};
+    EPD_2IN13_SetReg(0x21, UpdateControl, sizeof(UpdateControl)); //  Display update control
+
+    EPD_2IN13_SendCommand(0x18); // Read built-in temperature sensor
+    EPD_2IN13_SendData(0x80);
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+    ESP_LOGI(TAG, "e-Paper display initialized");
+    return EPD_2IN13_Release(0);
+}
+
+UBYTE EPD_2IN13_Init_Fast(void)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    ESP_LOGI(TAG, "Initializing e-Paper display (fast mode)...");
+    EPD_2IN13_Reset();
+
+    EPD_2IN13_SendCommand(0x12); // SWRESET
+    EPD_2IN13_InvalidateRegs();
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+
+    EPD_2IN13_SendCommand(0x18); // Read built-in temperature sensor
+    EPD_2IN13_SendData(0x80);
+
+    EPD_2IN13_SetRamArea(0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+
+    UBYTE LoadTemp = 0xB1;
+    EPD_2IN13_SetReg(0x22, &LoadTemp, 1); // Load temperature value
+    EPD_2IN13_SendCommand(0x20);
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+
+    EPD_2IN13_SendCommand(0x1A); // Write to temperature register
+    EPD_2IN13_SendData(0x64);
+    EPD_2IN13_SendData(0x00);
+
+    LoadTemp = 0x91;
+    EPD_2IN13_SetReg(0x22, &LoadTemp, 1); // Load temperature value
+    EPD_2IN13_SendCommand(0x20);
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+    ESP_LOGI(TAG, "e-Paper display initialized (fast mode)");
+    return EPD_2IN13_Release(0);
+}
+
+/******************************************************************************
+function :	Clear screen
+parameter:
+******************************************************************************/
+UBYTE EPD_2IN13_Clear(void)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    ESP_LOGI(TAG, "Clearing display to white...");
+    if (EPD_2IN13_FillRamValue(0x24, 0xFF) != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+    return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay());
+}
+
+UBYTE EPD_2IN13_Clear_Black(void)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    if (EPD_2IN13_FillRamValue(0x24, 0x00) != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+    return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay());
+}
+
+/******************************************************************************
+function :	Fill a controller RAM plane without refreshing
+parameter:
+    Ram   : EPD_2IN13_RAM_BW or EPD_2IN13_RAM_RED
+    Value : Fill byte, 0xFF and 0x00 are filled by the controller itself
+******************************************************************************/
+UBYTE EPD_2IN13_FillRam(UBYTE Ram, UBYTE Value)
+{
+    if (Ram != EPD_2IN13_RAM_BW && Ram != EPD_2IN13_RAM_RED)
+    {
+        ESP_LOGE(TAG, "Invalid RAM 0x%02X", Ram);
+        return 1;
+    }
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    return EPD_2IN13_Release(EPD_2IN13_FillRamValue(Ram, Value));
+}
+
+/******************************************************************************
+function :	Sends the image buffer in RAM to e-Paper and displays
+parameter:
+    Image : Image data
+******************************************************************************/
+UBYTE EPD_2IN13_Display(UBYTE *Image)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    EPD_2IN13_WriteRam(0x24, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay());
+}
+
+UBYTE EPD_2IN13_Display_Fast(UBYTE *Image)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    EPD_2IN13_WriteRam(0x24, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay_Fast());
+}
+
+/******************************************************************************
+function :	Refresh a base image
+parameter:
+    Image : Image data
+******************************************************************************/
+UBYTE EPD_2IN13_Display_Base(UBYTE *Image)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    EPD_2IN13_WriteRam(0x24, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1); // Write Black and White image to RAM
+    EPD_2IN13_WriteRam(0x26, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1); // Write Black and White image to RAM
+    return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay());
+}
+
+/******************************************************************************
+function :	Write byte-aligned windows to RAM, then run one partial refresh
+parameter:
+    Image   : Full frame image data
+    Windows : Windows to write
+    Count   : Number of windows
+******************************************************************************/
+static UBYTE EPD_2IN13_PartialWindows(const UBYTE *Image, const EPD_2IN13_WINDOW *Windows, UWORD Count)
+{
+    EPD_2IN13_PartialSetup();
+    for (UWORD i = 0; i < Count; i++)
+    {
+        const EPD_2IN13_WINDOW *W = &Windows[i];
+        EPD_2IN13_WriteRam(0x24, Image, W->XbStart, W->XbEnd, W->Ystart, W->Yend);
+    }
+    return EPD_2IN13_TurnOnDisplay_Partial();
+}
+
+/******************************************************************************
+function :	Coalesce windows whose union costs less than sending them apart
+parameter:
+    Windows : Windows to merge in place
+    Count   : Number of windows
+Info:
+    Returns the new number of windows
+******************************************************************************/
+static UWORD EPD_2IN13_MergeWindows(EPD_2IN13_WINDOW *Windows, UWORD Count)
+{
+    UBYTE Merged = 1;
+    while (Merged)
+    {
+        Merged = 0;
+        for (UWORD i = 0; i < Count && !Merged; i++)
+        {
+            for (UWORD j = i + 1; j < Count && !Merged; j++)
+            {
+                EPD_2IN13_WINDOW *A = &Windows[i];
+                EPD_2IN13_WINDOW *B = &Windows[j];
+                EPD_2IN13_WINDOW U = {
+                    .XbStart = (A->XbStart < B->XbStart) ? A->XbStart : B->XbStart,
+                    .XbEnd = (A->XbEnd > B->XbEnd) ? A->XbEnd : B->XbEnd,
+                    .Ystart = (A->Ystart < B->Ystart) ? A->Ystart : B->Ystart,
+                    .Yend = (A->Yend > B->Yend) ? A->Yend : B->Yend,
+                };
+                // Each extra window costs its 0x44/0x45/0x4E/0x4F setup, worth
+                // about EPD_2IN13_WINDOW_COST bytes of pixel data
+                if (EPD_2IN13_WindowBytes(&U) <= EPD_2IN13_WindowBytes(A) + EPD_2IN13_WindowBytes(B) + EPD_2IN13_WINDOW_COST)
+                {
+                    *A = U;
+                    Windows[j] = Windows[--Count];
+                    Merged = 1;
+                }
+            }
+        }
+    }
+    return Count;
+}
+
+/******************************************************************************
+function :	Sends the image buffer in RAM to e-Paper and partial refresh
+parameter:
+    Image : Image data
+******************************************************************************/
+UBYTE EPD_2IN13_Display_Partial(UBYTE *Image)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    EPD_2IN13_PartialSetup();
+    EPD_2IN13_WriteRam(0x24, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1); // Write Black and White image to RAM
+    return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay_Partial());
+}
+
+/******************************************************************************
+function :	Partial refresh of one region
+parameter:
+    Image  : Image data
+    X, Y   : Top left corner in panel coordinates
+    Width  : Region width, clipped to the panel
+    Height : Region height, clipped to the panel
+Info:
+    Returns 1 without touching the panel for an empty region or one that
+    starts outside the panel
+******************************************************************************/
+UBYTE EPD_2IN13_Display_PartialRegion(UBYTE *Image, UWORD X, UWORD Y, UWORD Width, UWORD Height)
+{
+    if (Width == 0 || Height == 0 || X >= EPD_2IN13_WIDTH || Y >= EPD_2IN13_HEIGHT)
+    {
+        ESP_LOGE(TAG, "Invalid partial region %dx%d at (%d,%d)", Width, Height, X, Y);
+        return 1;
+    }
+    UWORD x_end = (X + Width - 1 < EPD_2IN13_WIDTH) ? X + Width - 1 : EPD_2IN13_WIDTH - 1;
+    UWORD y_end = (Y + Height - 1 < EPD_2IN13_HEIGHT) ? Y + Height - 1 : EPD_2IN13_HEIGHT - 1;
+
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    EPD_2IN13_WINDOW Window = {X / 8, x_end / 8, Y, y_end};
+    return EPD_2IN13_Release(EPD_2IN13_PartialWindows(Image, &Window, 1));
+}
+
+/******************************************************************************
+function :	Render the frame band by band and stream each band to RAM
+parameter:
+    Band     : Buffer of BandRows * EPD_2IN13_LINE_BYTES bytes
+    BandRows : Panel rows per band
+    Render   : Fills Band with the panel rows from Ystart, returns 0 on success
+    Ctx      : Passed to Render
+    Refresh  : Refresh run once every band is written
+Info:
+    Only one band is held in memory, no full frame is needed. Bands are in
+    panel order whatever the layout set with EPD_2IN13_SetLayout.
+******************************************************************************/
+UBYTE EPD_2IN13_Display_Bands(UBYTE *Band, UWORD BandRows, EPD_2IN13_BAND_FN Render, void *Ctx,
+                              EPD_2IN13_REFRESH Refresh)
+{
+    if (Band == NULL || BandRows == 0 || Render == NULL || (unsigned)Refresh > EPD_2IN13_REFRESH_PARTIAL)
+    {
+        ESP_LOGE(TAG, "Invalid band refresh parameters");
+        return 1;
+    }
+
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    if (Refresh == EPD_2IN13_REFRESH_PARTIAL)
+    {
+        EPD_2IN13_PartialSetup();
+    }
+    for (UWORD y = 0; y < EPD_2IN13_HEIGHT; y += BandRows)
+    {
+        UWORD Rows = (EPD_2IN13_HEIGHT - y < BandRows) ? (EPD_2IN13_HEIGHT - y) : BandRows;
+        if (Render(Band, y, Rows, Ctx) != 0)
+        {
+            ESP_LOGE(TAG, "Rendering the band at row %d failed", y);
+            s_shadow_valid = 0; // RAM holds part of the new frame
+            return EPD_2IN13_Release(1);
+        }
+        EPD_2IN13_WriteRows(0x24, Band, 0, EPD_2IN13_LINE_BYTES - 1, y, y + Rows - 1);
+        if (Refresh == EPD_2IN13_REFRESH_BASE)
+        {
+            EPD_2IN13_WriteRows(0x26, Band, 0, EPD_2IN13_LINE_BYTES - 1, y, y + Rows - 1);
+        }
+    }
+    if (s_shadow)
+    {
+        s_shadow_valid = 1;
+    }
+
+    switch (Refresh)
+    {
+    case EPD_2IN13_REFRESH_FAST:
+        return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay_Fast());
+    case EPD_2IN13_REFRESH_PARTIAL:
+        return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay_Partial());
+    default:
+        return EPD_2IN13_Release(EPD_2IN13_TurnOnDisplay());
+    }
+}
+
+/******************************************************************************
+function :	Waveform LUTs for the host-loaded refresh profiles
+Info:
+    153 bytes for register 0x32 (5 x 12 VS, 12 x 7 timing groups, 6 frame
+    rate, 3 gate scan), followed by 0x3F end option, 0x03 VGH,
+    0x04 VSH1/VSH2/VSL and 0x2C VCOM.
+******************************************************************************/
+#define EPD_2IN13_LUT_WAVEFORM 153
+
+// Low-ghosting full refresh, drives every pixel black and white twice
+static const UBYTE EPD_2IN13_LUT_Full[EPD_2IN13_LUT_SIZE] = {
+    0x80, 0x4A, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x40, 0x4A, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x80, 0x4A, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x40, 0x4A, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0F, 0x00, 0x00, 0x0F, 0x00, 0x00, 0x02,
+    0x0F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00, 0x00,
+    0x22, 0x17, 0x41, 0x00, 0x32, 0x36,
+};
+
+// Partial refresh, only pixels that differ from the previous frame move
+static const UBYTE EPD_2IN13_LUT_Partial[EPD_2IN13_LUT_SIZE] = {
+    0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00, 0x00,
+    0x22, 0x17, 0x41, 0x00, 0x32, 0x36,
+};
+
+// Partial refresh with the drive phase cut to 10 frames, for clocks and counters.
+// Leaves more ghosting, run a full refresh every few minutes.
+static const UBYTE EPD_2IN13_LUT_PartialFast[EPD_2IN13_LUT_SIZE] = {
+    0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x00, 0x00, 0x00,
+    0x22, 0x17, 0x41, 0x00, 0x32, 0x36,
+};
+
+// Four gray levels from the two RAM planes, full refresh
+static const UBYTE EPD_2IN13_LUT_Gray4[EPD_2IN13_LUT_SIZE] = {
+    0x00, 0x60, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x20, 0x60, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x28, 0x60, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x2A, 0x60, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x02, 0x00, 0x05, 0x14, 0x00, 0x00,
+    0x1E, 0x1E, 0x00, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x02, 0x00, 0x05, 0x14, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x24, 0x22, 0x22, 0x22, 0x23, 0x32, 0x00, 0x00, 0x00,
+    0x22, 0x17, 0x41, 0xAE, 0x32, 0x28,
+};
+
+/**
+ * Refresh profile: waveform and whether it runs as a partial update
+ **/
+typedef struct
+{
+    const UBYTE *Lut;
+    UBYTE Partial;
+} EPD_2IN13_PROFILE;
+
+static EPD_2IN13_PROFILE s_profiles[EPD_2IN13_LUT_COUNT] = {
+    [EPD_2IN13_LUT_FULL] = {EPD_2IN13_LUT_Full, 0},
+    [EPD_2IN13_LUT_PARTIAL] = {EPD_2IN13_LUT_Partial, 1},
+    [EPD_2IN13_LUT_PARTIAL_FAST] = {EPD_2IN13_LUT_PartialFast, 1},
+    [EPD_2IN13_LUT_CUSTOM] = {NULL, 0},
+};
+static UDOUBLE s_profile_busy_us[EPD_2IN13_LUT_COUNT];
+
+/******************************************************************************
+function :	Load a waveform and its driving voltages into the controller
+parameter:
+    Lut : EPD_2IN13_LUT_SIZE bytes table
+******************************************************************************/
+static UBYTE EPD_2IN13_LoadLut(const UBYTE *Lut)
+{
+    // Still in the LUT register since the last reset or OTP load
+    if (Lut == s_lut_loaded)
+    {
+        return 0;
+    }
+
+    // Tables may live in flash, stage the waveform and the voltages for DMA
+    memcpy(s_bounce, Lut, EPD_2IN13_LUT_SIZE);
+    EPD_2IN13_SendCommand(0x32);
+    EPD_2IN13_SendDataBuffer(s_bounce, EPD_2IN13_LUT_WAVEFORM);
+    if (EPD_2IN13_ReadBusy() != 0)
+    {
+        return 1;
+    }
+
+    EPD_2IN13_SetReg(0x3F, &s_bounce[153], 1); // End option
+    EPD_2IN13_SetReg(0x03, &s_bounce[154], 1); // Gate voltage
+    EPD_2IN13_SetReg(0x04, &s_bounce[155], 3); // Source voltage
+    EPD_2IN13_SetReg(0x2C, &s_bounce[158], 1); // VCOM
+    s_lut_loaded = Lut;
+    return 0;
+}
+
+/******************************************************************************
+function :	Set the waveform used by EPD_2IN13_LUT_CUSTOM
+parameter:
+    Lut     : EPD_2IN13_LUT_SIZE bytes table, must stay valid while in use
+    Partial : 1 to refresh only changed pixels, 0 for a full refresh
+Info:
+    Call again after changing the table contents so it is reloaded.
+******************************************************************************/
+UBYTE EPD_2IN13_SetCustomLut(const UBYTE *Lut, UBYTE Partial)
+{
+    if (Lut == NULL)
+    {
+        return 1;
+    }
+
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    if (Lut == s_lut_loaded)
+    {
+        s_lut_loaded = NULL;
+    }
+    s_profiles[EPD_2IN13_LUT_CUSTOM].Lut = Lut;
+    s_profiles[EPD_2IN13_LUT_CUSTOM].Partial = Partial;
+    s_profile_busy_us[EPD_2IN13_LUT_CUSTOM] = 0;
+    return EPD_2IN13_Release(0);
+}
+
+/******************************************************************************
+function :	Refresh the whole frame with a host-loaded waveform
+parameter:
+    Image   : Image data
+    Profile : Waveform to drive the panel with
+Info:
+    Partial profiles compare against the previous frame like
+    EPD_2IN13_Display_Partial, full profiles also set the base image.
+******************************************************************************/
+UBYTE EPD_2IN13_Display_Lut(UBYTE *Image, EPD_2IN13_LUT Profile)
+{
+    if (Profile >= EPD_2IN13_LUT_COUNT || s_profiles[Profile].Lut == NULL)
+    {
+        ESP_LOGE(TAG, "No waveform for LUT profile %d", (int)Profile);
+        return 1;
+    }
+
+    const EPD_2IN13_PROFILE *P = &s_profiles[Profile];
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    if (P->Partial)
+    {
+        EPD_2IN13_PartialSetup();
+    }
+    if (EPD_2IN13_LoadLut(P->Lut) != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+
+    EPD_2IN13_WriteRam(0x24, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    if (!P->Partial)
+    {
+        EPD_2IN13_WriteRam(0x26, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    }
+
+    // Run the loaded waveform without reloading OTP, display mode 2 for partial
+    UBYTE Ret = EPD_2IN13_Update(P->Partial ? 0xCF : 0xC7);
+    s_profile_busy_us[Profile] = s_timing.Busy_us;
+    return EPD_2IN13_Release(Ret);
+}
+
+/******************************************************************************
+function :	BUSY time of the most recent refresh with a LUT profile
+parameter:
+    Profile : Waveform profile
+Info:
+    Returns 0 when the profile has not been used yet.
+******************************************************************************/
+UDOUBLE EPD_2IN13_GetLutBusyTime(EPD_2IN13_LUT Profile)
+{
+    if (Profile >= EPD_2IN13_LUT_COUNT)
+    {
+        return 0;
+    }
+    return s_profile_busy_us[Profile];
+}
+
+/******************************************************************************
+function :	Gather one bit of each pixel from 16 packed 2-bit pixels
+parameter:
+    Word  : 16 pixels, the first one in the top two bits
+    Shift : 1 for the high bit of each pixel, 0 for the low bit
+Info:
+    Returns the 16 gathered bits, the first pixel in bit 15.
+******************************************************************************/
+static inline uint32_t EPD_2IN13_GatherBits(uint32_t Word, UBYTE Shift)
+{
+    uint32_t x = (Word >> Shift) & 0x55555555;
+    x = (x | (x >> 1)) & 0x33333333;
+    x = (x | (x >> 2)) & 0x0F0F0F0F;
+    x = (x | (x >> 4)) & 0x00FF00FF;
+    x = (x | (x >> 8)) & 0x0000FFFF;
+    return x;
+}
+
+/******************************************************************************
+function :	Convert one 2bpp row to a 1bpp RAM plane row
+parameter:
+    Src   : EPD_2IN13_GRAY_LINE_BYTES bytes, 4 pixels per byte
+    Dst   : EPD_2IN13_LINE_BYTES bytes
+    Shift : 1 for the high bit of each pixel, 0 for the low bit
+******************************************************************************/
+static void EPD_2IN13_GrayRow(const UBYTE *Src, UBYTE *Dst, UBYTE Shift)
+{
+    UWORD i = 0, j = 0;
+
+    // Whole words: 4 source bytes give 2 plane bytes
+    for (; j + 4 <= EPD_2IN13_GRAY_LINE_BYTES; i += 2, j += 4)
+    {
+        uint32_t Word = ((uint32_t)Src[j] << 24) | ((uint32_t)Src[j + 1] << 16) |
+                        ((uint32_t)Src[j + 2] << 8) | Src[j + 3];
+        uint32_t Bits = EPD_2IN13_GatherBits(Word, Shift);
+        Dst[i] = (UBYTE)(Bits >> 8);
+        Dst[i + 1] = (UBYTE)Bits;
+    }
+
+    // Row tail, padded with white pixels
+    if (i < EPD_2IN13_LINE_BYTES)
+    {
+        uint32_t Word = 0;
+        for (UWORD k = 0; k < 4; k++)
+        {
+            Word = (Word << 8) | ((j + k < EPD_2IN13_GRAY_LINE_BYTES) ? Src[j + k] : 0xFF);
+        }
+        uint32_t Bits = EPD_2IN13_GatherBits(Word, Shift);
+        Dst[i] = (UBYTE)(Bits >> 8);
+        if (i + 1 < EPD_2IN13_LINE_BYTES)
+        {
+            Dst[i + 1] = (UBYTE)Bits;
+        }
+    }
+}
+
+/******************************************************************************
+function :	Convert a 2bpp frame to one RAM plane and write it
+parameter:
+    Reg   : RAM write command, 0x24 (B/W) or 0x26 (RED)
+    Image : 2bpp image data
+    Shift : 1 for the high bit of each pixel, 0 for the low bit
+******************************************************************************/
+static void EPD_2IN13_WriteGrayPlane(UBYTE Reg, const UBYTE *Image, UBYTE Shift)
+{
+    const UWORD Rows = EPD_2IN13_BOUNCE_SIZE / EPD_2IN13_LINE_BYTES;
+    int64_t Start = esp_timer_get_time();
+
+    EPD_2IN13_SetRamArea(0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    EPD_2IN13_SendCommand(Reg);
+    DEV_Digital_Write(EPD_DC_PIN, 1);
+    DEV_Digital_Write(EPD_CS_PIN, 0);
+    for (UWORD y = 0; y < EPD_2IN13_HEIGHT; y += Rows)
+    {
+        UWORD Count = (EPD_2IN13_HEIGHT - y < Rows) ? (EPD_2IN13_HEIGHT - y) : Rows;
+        for (UWORD r = 0; r < Count; r++)
+        {
+            UBYTE *Dst = &s_bounce[r * EPD_2IN13_LINE_BYTES];
+            if (s_orientation & EPD_2IN13_ORIENT_MIRROR_X)
+            {
+                UBYTE Line[EPD_2IN13_LINE_BYTES];
+                EPD_2IN13_GrayRow(&Image[(UDOUBLE)(y + r) * EPD_2IN13_GRAY_LINE_BYTES], Line, Shift);
+                EPD_2IN13_MirrorRow(Line, Dst);
+            }
+            else
+            {
+                EPD_2IN13_GrayRow(&Image[(UDOUBLE)(y + r) * EPD_2IN13_GRAY_LINE_BYTES], Dst, Shift);
+            }
+        }
+        DEV_SPI_Write_nByte(s_bounce, (UDOUBLE)Count * EPD_2IN13_LINE_BYTES);
+    }
+    DEV_Digital_Write(EPD_CS_PIN, 1);
+    EPD_2IN13_InvalidateCursor();
+    s_upload_us += (UDOUBLE)(esp_timer_get_time() - Start);
+}
+
+/******************************************************************************
+function :	Show a 4-level grayscale image
+parameter:
+    Image : Image drawn with Paint_SetScale(4), 2 bits per pixel
+Info:
+    The high bit of each pixel goes to the B/W RAM and the low bit to the RED
+    RAM. Run EPD_2IN13_Display_Base before the next partial refresh. The
+    grayscale waveform stays loaded until a refresh that loads OTP, which
+    EPD_2IN13_Display_Fast does first.
+******************************************************************************/
+UBYTE EPD_2IN13_Display_4Gray(UBYTE *Image)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    if (EPD_2IN13_LoadLut(EPD_2IN13_LUT_Gray4) != 0)
+    {
+        return EPD_2IN13_Release(1);
+    }
+
+    EPD_2IN13_WriteGrayPlane(0x24, Image, 1);
+    EPD_2IN13_WriteGrayPlane(0x26, Image, 0);
+    if (s_shadow)
+    {
+        s_shadow_valid = 0; // B/W RAM no longer holds a 1bpp frame
+    }
+    return EPD_2IN13_Release(EPD_2IN13_Update(0xC7));
+}
+
+/******************************************************************************
+function :	Partial refresh of several regions in a single refresh cycle
+parameter:
+    Image : Image data
+    Rects : Regions in panel coordinates
+    Count : Number of regions
+Info:
+    Nearby regions are coalesced when one larger window is cheaper to send.
+    Empty regions and ones starting outside the panel are skipped, returns 1
+    without touching the panel when none is left.
+******************************************************************************/
+UBYTE EPD_2IN13_Display_PartialRegions(UBYTE *Image, const EPD_2IN13_RECT *Rects, UWORD Count)
+{
+    EPD_2IN13_WINDOW Windows[EPD_2IN13_MAX_REGIONS];
+    UWORD n = 0;
+
+    if (Rects == NULL)
+    {
+        ESP_LOGE(TAG, "No partial regions given");
+        return 1;
+    }
+
+    for (UWORD i = 0; i < Count; i++)
+    {
+        const EPD_2IN13_RECT *R = &Rects[i];
+        if (R->Width == 0 || R->Height == 0 || R->X >= EPD_2IN13_WIDTH || R->Y >= EPD_2IN13_HEIGHT)
+        {
+            ESP_LOGW(TAG, "Skipping invalid partial region %d: %dx%d at (%d,%d)", i, R->Width, R->Height, R->X,
+                     R->Y);
+            continue;
+        }
+        UWORD x_end = (R->X + R->Width - 1 < EPD_2IN13_WIDTH) ? R->X + R->Width - 1 : EPD_2IN13_WIDTH - 1;
+        UWORD y_end = (R->Y + R->Height - 1 < EPD_2IN13_HEIGHT) ? R->Y + R->Height - 1 : EPD_2IN13_HEIGHT - 1;
+        EPD_2IN13_WINDOW W = {R->X / 8, x_end / 8, R->Y, y_end};
+
+        if (n == EPD_2IN13_MAX_REGIONS)
+        {
+            // Out of slots, fold the rest into the last window
+            EPD_2IN13_WINDOW *L = &Windows[n - 1];
+            L->XbStart = (W.XbStart < L->XbStart) ? W.XbStart : L->XbStart;
+            L->XbEnd = (W.XbEnd > L->XbEnd) ? W.XbEnd : L->XbEnd;
+            L->Ystart = (W.Ystart < L->Ystart) ? W.Ystart : L->Ystart;
+            L->Yend = (W.Yend > L->Yend) ? W.Yend : L->Yend;
+            continue;
+        }
+        Windows[n++] = W;
+    }
+    if (n == 0)
+    {
+        ESP_LOGE(TAG, "No valid partial region among %d", Count);
+        return 1;
+    }
+
+    n = EPD_2IN13_MergeWindows(Windows, n);
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    return EPD_2IN13_Release(EPD_2IN13_PartialWindows(Image, Windows, n));
+}
+
+/******************************************************************************
+function :	Enable or disable automatic partial refresh
+parameter:
+    Enable : 1 keeps a copy of the last frame sent, 0 frees it
+Info:
+    Returns 1 if the frame copy can't be allocated
+******************************************************************************/
+UBYTE EPD_2IN13_SetAutoPartial(UBYTE Enable)
+{
+    if (!Enable)
+    {
+        free(s_shadow);
+        s_shadow = NULL;
+        s_shadow_valid = 0;
+        return 0;
+    }
+    if (s_shadow == NULL)
+    {
+        s_shadow = (UBYTE *)malloc(EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+        if (s_shadow == NULL)
+        {
+            ESP_LOGE(TAG, "Failed to allocate auto partial frame copy");
+            return 1;
+        }
+        s_shadow_valid = 0;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function :	Partial refresh of only the area that changed since the last frame
+parameter:
+    Image : Image data
+Info:
+    The first call after enabling sends the whole frame. Nothing is sent and
+    no refresh happens when the frame is unchanged.
+******************************************************************************/
+UBYTE EPD_2IN13_Display_PartialAuto(UBYTE *Image)
+{
+    EPD_2IN13_WINDOW Window = {0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1};
+
+    if (EPD_2IN13_SetAutoPartial(1) != 0)
+    {
+        return 1;
+    }
+
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    Image = EPD_2IN13_PanelFrame(Image);
+    if (s_shadow_valid &&
+        !EPD_2IN13_DiffBounds(s_shadow, Image, &Window.XbStart, &Window.XbEnd, &Window.Ystart, &Window.Yend))
+    {
+        Debug("Frame unchanged, skipping refresh\r\n");
+        return EPD_2IN13_Release(0);
+    }
+    return EPD_2IN13_Release(EPD_2IN13_PartialWindows(Image, &Window, 1));
+}
+
+/******************************************************************************
+function :	Upload a frame and start its refresh, called with the lock held
+parameter:
+    Image : Image data
+    Job   : Refresh to start
+******************************************************************************/
+static void EPD_2IN13_Async_Start(const UBYTE *Image, const EPD_2IN13_JOB *Job)
+{
+    if (Job->Partial)
+    {
+        EPD_2IN13_PartialSetup();
+    }
+    EPD_2IN13_WriteRam(0x24, Image, 0, EPD_2IN13_LINE_BYTES - 1, 0, EPD_2IN13_HEIGHT - 1);
+    xEventGroupClearBits(s_async_events, EPD_2IN13_ASYNC_IDLE_BIT);
+    EPD_2IN13_Activate(Job->Mode);
+    s_async_running = *Job;
+}
+
+/******************************************************************************
+function :	Worker task, waits out each refresh and starts the pending one
+parameter:
+******************************************************************************/
+static void EPD_2IN13_Async_Task(void *Arg)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        UBYTE Busy;
+        do
+        {
+            int64_t Start = esp_timer_get_time();
+            UBYTE Status = EPD_2IN13_ReadBusy();
+
+            xSemaphoreTake(s_async_lock, portMAX_DELAY);
+            EPD_2IN13_JOB Done = s_async_running;
+            EPD_2IN13_JOB Dropped = {0};
+            s_timing.Busy_us = (UDOUBLE)(esp_timer_get_time() - Start);
+            Busy = s_async_has_pending && Status == 0;
+            if (s_async_has_pending)
+            {
+                s_async_has_pending = 0;
+                if (Status == 0)
+                {
+                    // The panel just released, so the controller RAM is free again
+                    EPD_2IN13_Async_Start(s_async_frame, &s_async_pending);
+                }
+                else
+                {
+                    // The panel may still be refreshing, don't touch its RAM
+                    ESP_LOGW(TAG, "BUSY timed out, dropping the queued frame");
+                    Dropped = s_async_pending;
+                }
+                xSemaphoreGive(s_async_slot);
+            }
+            if (!Busy)
+            {
+                xEventGroupSetBits(s_async_events, EPD_2IN13_ASYNC_IDLE_BIT);
+            }
+            xSemaphoreGive(s_async_lock);
+
+            if (Done.Cb)
+            {
+                Done.Cb(Status, Done.Ctx);
+            }
+            if (Dropped.Cb)
+            {
+                Dropped.Cb(1, Dropped.Ctx);
+            }
+        } while (Busy);
+    }
+}
+
+/******************************************************************************
+function :	Create the worker task and its resources on first use
+parameter:
+******************************************************************************/
+static UBYTE EPD_2IN13_Async_Begin(void)
+{
+    if (s_async_task)
+    {
+        return 0;
+    }
+
+    if (EPD_2IN13_LockBegin() != 0)
+    {
+        return 1;
+    }
+    s_async_slot = xSemaphoreCreateBinary();
+    s_async_frame = (UBYTE *)malloc(EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+    if (!s_async_slot || !s_async_frame)
+    {
+        ESP_LOGE(TAG, "Failed to allocate async refresh resources");
+        return 1;
+    }
+    xSemaphoreGive(s_async_slot);
+
+    if (xTaskCreate(EPD_2IN13_Async_Task, "epd_async", EPD_2IN13_ASYNC_STACK, NULL,
+                    EPD_2IN13_ASYNC_PRIO, &s_async_task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to start async refresh task");
+        s_async_task = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function :	Queue a refresh, uploading at once if the panel is idle
+parameter:
+    Image   : Image data
+    Mode    : Display Update Control 2 sequence
+    Partial : Needs the partial-refresh register setup
+    Cb      : Completion callback, may be NULL
+    Ctx     : Passed to Cb
+******************************************************************************/
+static UBYTE EPD_2IN13_Async_Submit(UBYTE *Image, UBYTE Mode, UBYTE Partial, EPD_2IN13_DONE_CB Cb, void *Ctx)
+{
+    if (EPD_2IN13_Async_Begin() != 0)
+    {
+        return 1;
+    }
+
+    EPD_2IN13_JOB Job = {
+        .Mode = Mode,
+        .Partial = Partial,
+        .Cb = Cb,
+        .Ctx = Ctx,
+    };
+
+    // Only one frame waits behind the running refresh. A callback can't wait
+    // for the slot, since the worker it runs on is what frees it.
+    TickType_t Wait = (xTaskGetCurrentTaskHandle() == s_async_task) ? 0 : portMAX_DELAY;
+    if (xSemaphoreTake(s_async_slot, Wait) != pdTRUE)
+    {
+        ESP_LOGW(TAG, "Async refresh queue full");
+        return 1;
+    }
+
+    xSemaphoreTake(s_async_lock, portMAX_DELAY);
+    Image = EPD_2IN13_PanelFrame(Image);
+    if (xEventGroupGetBits(s_async_events) & EPD_2IN13_ASYNC_IDLE_BIT)
+    {
+        EPD_2IN13_Async_Start(Image, &Job);
+        xSemaphoreGive(s_async_slot);
+        xSemaphoreGive(s_async_lock);
+        xTaskNotifyGive(s_async_task);
+    }
+    else
+    {
+        // Controller RAM must not change mid-refresh, keep a copy for later
+        memcpy(s_async_frame, Image, EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+        s_async_pending = Job;
+        s_async_has_pending = 1;
+        xSemaphoreGive(s_async_lock);
+    }
+    return 0;
+}
+
+/******************************************************************************
+function :	Start a full refresh and return without waiting for BUSY
+parameter:
+    Image : Image data, free for reuse as soon as the call returns
+    Cb    : Called from the driver task once the refresh is done, may be NULL
+    Ctx   : Passed to Cb
+******************************************************************************/
+UBYTE EPD_2IN13_Display_Async(UBYTE *Image, EPD_2IN13_DONE_CB Cb, void *Ctx)
+{
+    return EPD_2IN13_Async_Submit(Image, 0xf7, 0, Cb, Ctx);
+}
+
+/******************************************************************************
+function :	Start a partial refresh and return without waiting for BUSY
+parameter:
+    Image : Image data, free for reuse as soon as the call returns
+    Cb    : Called from the driver task once the refresh is done, may be NULL
+    Ctx   : Passed to Cb
+******************************************************************************/
+UBYTE EPD_2IN13_Display_Partial_Async(UBYTE *Image, EPD_2IN13_DONE_CB Cb, void *Ctx)
+{
+    return EPD_2IN13_Async_Submit(Image, 0xff, 1, Cb, Ctx);
+}
+
+/******************************************************************************
+function :	Wait until all queued asynchronous refreshes have finished
+parameter:
+    Timeout_ms : Maximum time to wait, EPD_2IN13_WAIT_FOREVER to block
+******************************************************************************/
+UBYTE EPD_2IN13_WaitIdle(UDOUBLE Timeout_ms)
+{
+    if (s_async_events == NULL)
+    {
+        return 0;
+    }
+
+    EventBits_t Bits = xEventGroupGetBits(s_async_events);
+    if (!(Bits & EPD_2IN13_ASYNC_IDLE_BIT) && xTaskGetCurrentTaskHandle() != s_async_task)
+    {
+        TickType_t Ticks = (Timeout_ms == EPD_2IN13_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(Timeout_ms);
+        Bits = xEventGroupWaitBits(s_async_events, EPD_2IN13_ASYNC_IDLE_BIT, pdFALSE, pdTRUE, Ticks);
+    }
+    return (Bits & EPD_2IN13_ASYNC_IDLE_BIT) ? 0 : 1;
+}
+
+/******************************************************************************
+function :	Set how long to wait for BUSY before giving up
+parameter:
+    Timeout_ms : Maximum wait per operation, EPD_2IN13_WAIT_FOREVER to block
+******************************************************************************/
+void EPD_2IN13_SetBusyTimeout(UDOUBLE Timeout_ms)
+{
+    s_busy_timeout_ms = Timeout_ms;
+}
+
+/******************************************************************************
+function :	Timing of the most recent refresh
+parameter:
+    Timing : Filled with the measured durations
+******************************************************************************/
+void EPD_2IN13_GetTiming(EPD_2IN13_TIMING *Timing)
+{
+    *Timing = s_timing;
+}
+
+/******************************************************************************
+function :	Mirror or rotate the picture on the panel
+parameter:
+    Orientation : EPD_2IN13_ORIENT_NORMAL, _MIRROR_X, _MIRROR_Y or _ROTATE_180
+Info:
+    Frames keep being drawn in their natural layout. The vertical mirror is
+    done by the controller: Y-decrement data entry mode with the window and
+    cursor starting at the bottom row. The horizontal mirror is done on the
+    rows as they are sent, as the panel is not a whole number of bytes wide.
+    The next refresh should be a full one, the panel still shows the old
+    orientation.
+******************************************************************************/
+UBYTE EPD_2IN13_SetOrientation(EPD_2IN13_ORIENTATION Orientation)
+{
+    if ((unsigned)Orientation > EPD_2IN13_ORIENT_ROTATE_180)
+    {
+        ESP_LOGE(TAG, "Invalid orientation %d", (int)Orientation);
+        return 1;
+    }
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    if (Orientation != s_orientation)
+    {
+        s_orientation = Orientation;
+        s_shadow_valid = 0; // RAM holds the frame in the old orientation
+    }
+    return EPD_2IN13_Release(0);
+}
+
+/******************************************************************************
+function :	Convert a landscape frame to panel order
+parameter:
+    Src : EPD_2IN13_HEIGHT x EPD_2IN13_WIDTH frame, EPD_2IN13_LANDSCAPE_LINE_BYTES per row
+    Dst : Panel frame, EPD_2IN13_LINE_BYTES per row
+Info:
+    Landscape pixel (x, y) is panel pixel (EPD_2IN13_WIDTH - 1 - y, x), as
+    Paint draws with ROTATE_90. Each 8 x 8 pixel block is one transpose:
+    8 landscape rows of one byte column become 8 panel rows of one byte
+    column. Padding pixels past the last column come out white.
+******************************************************************************/
+static void EPD_2IN13_LandscapeToPanel(const UBYTE *Src, UBYTE *Dst)
+{
+    for (UWORD g = 0; g < EPD_2IN13_LANDSCAPE_LINE_BYTES; g++)
+    {
+        for (UWORD xb = 0; xb < EPD_2IN13_LINE_BYTES; xb++)
+        {
+            uint64_t Block = 0;
+            for (UWORD k = 0; k < 8; k++)
+            {
+                int y = EPD_2IN13_WIDTH - 1 - (8 * xb + k);
+                Block = (Block << 8) | ((y >= 0) ? Src[y * EPD_2IN13_LANDSCAPE_LINE_BYTES + g] : 0xFF);
+            }
+            Block = Frame_Transpose8x8(Block);
+            for (UWORD q = 0; q < 8 && 8 * g + q < EPD_2IN13_HEIGHT; q++)
+            {
+                Dst[(8 * g + q) * EPD_2IN13_LINE_BYTES + xb] = (UBYTE)(Block >> (56 - 8 * q));
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function :	Choose the layout of the frames passed to the display calls
+parameter:
+    Layout : EPD_2IN13_LAYOUT_PORTRAIT or EPD_2IN13_LAYOUT_LANDSCAPE
+Info:
+    Landscape needs a panel-order frame copy, returns 1 if it can't be
+    allocated. Waits for any asynchronous refresh, which may be converting
+    through that copy. 4-level grayscale images are always portrait.
+******************************************************************************/
+UBYTE EPD_2IN13_SetLayout(EPD_2IN13_LAYOUT Layout)
+{
+    if (Layout != EPD_2IN13_LAYOUT_PORTRAIT && Layout != EPD_2IN13_LAYOUT_LANDSCAPE)
+    {
+        ESP_LOGE(TAG, "Invalid layout %d", (int)Layout);
+        return 1;
+    }
+
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
+    if (Layout == EPD_2IN13_LAYOUT_LANDSCAPE)
+    {
+        if (s_panel == NULL)
+        {
+            s_panel = (UBYTE *)malloc(EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+            if (s_panel == NULL)
+            {
+                ESP_LOGE(TAG, "Failed to allocate landscape conversion frame");
+                return EPD_2IN13_Release(1);
+            }
+        }
+    }
+    else
+    {
+        free(s_panel);
+        s_panel = NULL;
+    }
+    s_layout = Layout;
+    return EPD_2IN13_Release(0);
+}
+
+/******************************************************************************
+function :	Frame in panel order for a frame in the current layout
+parameter:
+    Image : Frame in the layout set with EPD_2IN13_SetLayout
+Info:
+    Returns Image itself for portrait frames, otherwise the converted copy
+    in s_panel. Only call it with the controller lock held: s_panel is
+    shared by every display call.
+******************************************************************************/
+static UBYTE *EPD_2IN13_PanelFrame(UBYTE *Image)
+{
+    if (s_layout == EPD_2IN13_LAYOUT_PORTRAIT || Image == s_panel)
+    {
+        return Image;
+    }
+    EPD_2IN13_LandscapeToPanel(Image, s_panel);
+    return s_panel;
+}
+
+/******************************************************************************
+function :	Copy a frame in the current layout into a panel-order buffer
+parameter:
+    Image : Frame in the layout set with EPD_2IN13_SetLayout
+    Panel : EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT bytes, gets the frame
+Info:
+    Portrait frames are copied as they are. Panel is the caller's own, so
+    it can be read while other tasks use the display.
+******************************************************************************/
+void EPD_2IN13_ToPanel(const UBYTE *Image, UBYTE *Panel)
+{
+    if (s_layout == EPD_2IN13_LAYOUT_LANDSCAPE)
+    {
+        EPD_2IN13_LandscapeToPanel(Image, Panel);
+    }
+    else
+    {
+        memcpy(Panel, Image, EPD_2IN13_LINE_BYTES * EPD_2IN13_HEIGHT);
+    }
+}
+
+/******************************************************************************
+function :	Enter sleep mode
+parameter:
+******************************************************************************/
+UBYTE EPD_2IN13_Sleep(void)
+{
+    if (EPD_2IN13_Claim() != 0)
+    {
+        return 1;
+    }
     ESP_LOGI(TAG, "Entering deep sleep mode...");
     EPD_2IN13_SendCommand(0x10); // enter deep sleep
     EPD_2IN13_SendData(0x01);
+    EPD_2IN13_InvalidateRegs(); // Waking up takes a hardware reset
     DEV_Delay_ms(100);
     ESP_LOGI(TAG, "Display in deep sleep");
+    return EPD_2IN13_Release(0);
 }
@@ -0,0 +1,351 @@
+/*****************************************************************************
+ * | File      	:   EPD_2in13_Sched.c
+ * | Author      :
+ * | Function    :   Ghosting-aware refresh scheduler for the 2.13inch e-paper
+ * | Info        :
+ *   Runs partial refreshes and inserts a clean-up refresh once the
+ *   configured ghosting budget is used up.
+ *----------------
+ * |	This version:   V1.0
+ * | Date        :
+ * | Info        :
+ * -----------------------------------------------------------------------------
+ ******************************************************************************/
+#include "EPD_2in13_Sched.h"
+#include "Debug.h"
+#include "Frame_Ops.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "EPD_SCHED";
+
+#define EPD_2IN13_SCHED_LINE_BYTES ((EPD_2IN13_WIDTH % 8 == 0) ? (EPD_2IN13_WIDTH / 8) : (EPD_2IN13_WIDTH / 8 + 1))
+#define EPD_2IN13_SCHED_FRAME_BYTES (EPD_2IN13_SCHED_LINE_BYTES * EPD_2IN13_HEIGHT)
+// One 32-bit word per tile row
+#define EPD_2IN13_SCHED_TILE_WORDS (EPD_2IN13_SCHED_TILE / 32)
+
+static EPD_2IN13_SCHED_CONFIG s_config;
+static EPD_2IN13_SCHED_STATS s_stats;
+static UBYTE *s_prev;          // Frame shown on the panel, in panel order
+static UBYTE *s_next;          // Frame being shown, converted by the scheduler itself
+static UBYTE s_prev_valid;
+static int64_t s_clean_time_us;
+
+/******************************************************************************
+function :	Start scheduling refreshes
+parameter:
+    Config : Ghosting budget, NULL for EPD_2IN13_SCHED_CONFIG_DEFAULT
+Info:
+    The display must be initialized. The first frame gets a clean-up refresh.
+******************************************************************************/
+UBYTE EPD_2IN13_Sched_Init(const EPD_2IN13_SCHED_CONFIG *Config)
+{
+    static const EPD_2IN13_SCHED_CONFIG Default = EPD_2IN13_SCHED_CONFIG_DEFAULT;
+
+    if (Config == NULL)
+    {
+        Config = &Default;
+    }
+    if (Config->PartialProfile != EPD_2IN13_SCHED_OTP &&
+        Config->PartialProfile != EPD_2IN13_LUT_PARTIAL &&
+        Config->PartialProfile != EPD_2IN13_LUT_PARTIAL_FAST &&
+        Config->PartialProfile != EPD_2IN13_LUT_CUSTOM)
+    {
+        ESP_LOGE(TAG, "Partial profile %d is not a partial waveform", (int)Config->PartialProfile);
+        return 1;
+    }
+
+    if (s_prev == NULL)
+    {
+        s_prev = (UBYTE *)malloc(EPD_2IN13_SCHED_FRAME_BYTES);
+        s_next = (UBYTE *)malloc(EPD_2IN13_SCHED_FRAME_BYTES);
+        if (s_prev == NULL || s_next == NULL)
+        {
+            ESP_LOGE(TAG, "Failed to allocate scheduler frame copies");
+            free(s_prev);
+            free(s_next);
+            s_prev = s_next = NULL;
+            return 1;
+        }
+    }
+    s_config = *Config;
+    s_prev_valid = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    return 0;
+}
+
+/******************************************************************************
+function :	Stop scheduling and free the frame copy
+parameter:
+******************************************************************************/
+void EPD_2IN13_Sched_Exit(void)
+{
+    free(s_prev);
+    free(s_next);
+    s_prev = s_next = NULL;
+    s_prev_valid = 0;
+}
+
+/******************************************************************************
+function :	Clear the budget used since the last clean-up
+parameter:
+******************************************************************************/
+static void EPD_2IN13_Sched_ResetBudget(void)
+{
+    s_stats.ChangedPixels = 0;
+    s_stats.SinceClean_ms = 0;
+    s_stats.MaxTilePartials = 0;
+    memset(s_stats.TilePartials, 0, sizeof(s_stats.TilePartials));
+    s_clean_time_us = esp_timer_get_time();
+}
+
+/******************************************************************************
+function :	Keep s_next as the frame on the panel
+parameter:
+******************************************************************************/
+static void EPD_2IN13_Sched_Shown(void)
+{
+    UBYTE *Shown = s_next;
+    s_next = s_prev;
+    s_prev = Shown;
+    s_prev_valid = 1;
+}
+
+/******************************************************************************
+function :	Run a clean-up refresh and restart the budget
+parameter:
+    Image  : Image data, s_next holds it in panel order
+    Reason : Why the clean-up runs
+******************************************************************************/
+static UBYTE EPD_2IN13_Sched_Run_Clean(UBYTE *Image, EPD_2IN13_SCHED_REASON Reason)
+{
+    UBYTE Ret;
+    if (s_config.Clean == EPD_2IN13_SCHED_CLEAN_FAST)
+    {
+        Ret = EPD_2IN13_Display_Lut(Image, EPD_2IN13_LUT_FULL);
+    }
+    else
+    {
+        Ret = EPD_2IN13_Display_Base(Image);
+    }
+    if (Ret != 0)
+    {
+        // The panel may not show this frame, the next one starts with a clean-up
+        s_prev_valid = 0;
+        return Ret;
+    }
+
+    EPD_2IN13_Sched_Shown();
+    EPD_2IN13_Sched_ResetBudget();
+
+    s_stats.Cleans++;
+    s_stats.LastReason = Reason;
+    switch (Reason)
+    {
+    case EPD_2IN13_SCHED_REASON_TILE:
+        s_stats.CleansByTile++;
+        break;
+    case EPD_2IN13_SCHED_REASON_AREA:
+        s_stats.CleansByArea++;
+        break;
+    case EPD_2IN13_SCHED_REASON_TIME:
+        s_stats.CleansByTime++;
+        break;
+    default:
+        break;
+    }
+    Debug("Clean-up refresh, reason %d\r\n", (int)Reason);
+    return Ret;
+}
+
+/******************************************************************************
+function :	Force a clean-up refresh
+parameter:
+    Image : Image data
+******************************************************************************/
+UBYTE EPD_2IN13_Sched_Clean(UBYTE *Image)
+{
+    if (s_prev == NULL)
+    {
+        ESP_LOGE(TAG, "Scheduler not initialized");
+        return 1;
+    }
+    EPD_2IN13_ToPanel(Image, s_next);
+    return EPD_2IN13_Sched_Run_Clean(Image, EPD_2IN13_SCHED_REASON_FORCED);
+}
+
+/******************************************************************************
+function :	Show a frame, as a partial refresh while the budget allows
+parameter:
+    Image : Image data
+Info:
+    Nothing is sent when the frame is unchanged. Otherwise changed pixels are
+    counted per tile, and a clean-up refresh replaces the partial one when
+    this frame would use up the budget.
+******************************************************************************/
+UBYTE EPD_2IN13_Sched_Display(UBYTE *Image)
+{
+    UDOUBLE Changed[EPD_2IN13_SCHED_TILES] = {0};
+    UDOUBLE Total = 0;
+    UWORD Ystart = EPD_2IN13_HEIGHT, Yend = 0;
+    UWORD TxStart = EPD_2IN13_SCHED_TILES_X, TxEnd = 0;
+
+    if (s_prev == NULL)
+    {
+        ESP_LOGE(TAG, "Scheduler not initialized");
+        return 1;
+    }
+    // Tiles are counted in panel order, on a copy no other task writes to.
+    // The display calls still get Image and convert it themselves.
+    EPD_2IN13_ToPanel(Image, s_next);
+    if (!s_prev_valid)
+    {
+        return EPD_2IN13_Sched_Run_Clean(Image, EPD_2IN13_SCHED_REASON_FIRST);
+    }
+
+    // Padding bits past the last column never reach the panel
+    UBYTE Tail[EPD_2IN13_SCHED_TILE_WORDS * 4 * EPD_2IN13_SCHED_TILES_X];
+    memset(Tail, 0xFF, sizeof(Tail));
+    memset(Tail + EPD_2IN13_SCHED_LINE_BYTES, 0x00, sizeof(Tail) - EPD_2IN13_SCHED_LINE_BYTES);
+    if (EPD_2IN13_WIDTH % 8)
+    {
+        Tail[EPD_2IN13_SCHED_LINE_BYTES - 1] = (UBYTE)(0xFF << (8 - EPD_2IN13_WIDTH % 8));
+    }
+
+    for (UWORD y = 0; y < EPD_2IN13_HEIGHT; y++)
+    {
+        const UBYTE *New = s_next + (UDOUBLE)y * EPD_2IN13_SCHED_LINE_BYTES;
+        const UBYTE *Old = s_prev + (UDOUBLE)y * EPD_2IN13_SCHED_LINE_BYTES;
+        UDOUBLE *Row = &Changed[(y / EPD_2IN13_SCHED_TILE) * EPD_2IN13_SCHED_TILES_X];
+
+        for (UWORD xb = 0; xb < EPD_2IN13_SCHED_LINE_BYTES; xb += 4)
+        {
+            uint32_t a = 0, b = 0, m;
+            UWORD n = (EPD_2IN13_SCHED_LINE_BYTES - xb < 4) ? (EPD_2IN13_SCHED_LINE_BYTES - xb) : 4;
+            memcpy(&a, New + xb, n);
+            memcpy(&b, Old + xb, n);
+            memcpy(&m, Tail + xb, 4);
+            uint32_t Diff = (a ^ b) & m;
+            if (Diff == 0)
+            {
+                continue;
+            }
+
+            UWORD Tx = xb / (4 * EPD_2IN13_SCHED_TILE_WORDS);
+            UBYTE Bits = (UBYTE)Frame_Popcount32(Diff);
+            Row[Tx] += Bits;
+            Total += Bits;
+            if (y < Ystart)
+            {
+                Ystart = y;
+            }
+            Yend = y;
+            if (Tx < TxStart)
+            {
+                TxStart = Tx;
+            }
+            if (Tx > TxEnd)
+            {
+                TxEnd = Tx;
+            }
+        }
+    }
+
+    if (Total == 0)
+    {
+        s_stats.Skipped++;
+        return 0;
+    }
+
+    // Would this frame use up the budget?
+    EPD_2IN13_SCHED_REASON Reason = EPD_2IN13_SCHED_REASON_NONE;
+    UDOUBLE Elapsed_ms = (UDOUBLE)((esp_timer_get_time() - s_clean_time_us) / 1000);
+    if (s_config.MaxTilePartials)
+    {
+        for (UWORD t = 0; t < EPD_2IN13_SCHED_TILES; t++)
+        {
+            if (Changed[t] && s_stats.TilePartials[t] + 1 > s_config.MaxTilePartials)
+            {
+                Reason = EPD_2IN13_SCHED_REASON_TILE;
+                break;
+            }
+        }
+    }
+    if (Reason == EPD_2IN13_SCHED_REASON_NONE && s_config.MaxChangedPixels &&
+        s_stats.ChangedPixels + Total > s_config.MaxChangedPixels)
+    {
+        Reason = EPD_2IN13_SCHED_REASON_AREA;
+    }
+    if (Reason == EPD_2IN13_SCHED_REASON_NONE && s_config.MaxInterval_ms &&
+        Elapsed_ms >= s_config.MaxInterval_ms)
+    {
+        Reason = EPD_2IN13_SCHED_REASON_TIME;
+    }
+    if (Reason != EPD_2IN13_SCHED_REASON_NONE)
+    {
+        return EPD_2IN13_Sched_Run_Clean(Image, Reason);
+    }
+
+    UBYTE Ret;
+    if (s_config.PartialProfile == EPD_2IN13_SCHED_OTP)
+    {
+        // Only the rows and tile columns that changed are uploaded
+        UWORD X = TxStart * EPD_2IN13_SCHED_TILE;
+        UWORD Width = (TxEnd + 1) * EPD_2IN13_SCHED_TILE - X;
+        Ret = EPD_2IN13_Display_PartialRegion(Image, X, Ystart, Width, Yend - Ystart + 1);
+    }
+    else
+    {
+        Ret = EPD_2IN13_Display_Lut(Image, s_config.PartialProfile);
+    }
+    if (Ret != 0)
+    {
+        s_prev_valid = 0;
+        return Ret;
+    }
+
+    for (UWORD t = 0; t < EPD_2IN13_SCHED_TILES; t++)
+    {
+        if (Changed[t])
+        {
+            s_stats.TilePartials[t]++;
+            if (s_stats.TilePartials[t] > s_stats.MaxTilePartials)
+            {
+                s_stats.MaxTilePartials = s_stats.TilePartials[t];
+            }
+        }
+    }
+    s_stats.ChangedPixels += Total;
+    s_stats.Partials++;
+    EPD_2IN13_Sched_Shown();
+    return Ret;
+}
+
+/******************************************************************************
+function :	Read the scheduler counters
+parameter:
+    Stats : Filled with the counters
+******************************************************************************/
+void EPD_2IN13_Sched_GetStats(EPD_2IN13_SCHED_STATS *Stats)
+{
+    *Stats = s_stats;
+    if (s_prev_valid)
+    {
+        Stats->SinceClean_ms = (UDOUBLE)((esp_timer_get_time() - s_clean_time_us) / 1000);
+    }
+}
+
+/******************************************************************************
+function :	Zero the totals, the budget in use is kept
+parameter:
+******************************************************************************/
+void EPD_2IN13_Sched_ResetStats(void)
+{
+    s_stats.Partials = 0;
+    s_stats.Cleans = 0;
+    s_stats.Skipped = 0;
+    s_stats.CleansByTile = 0;
+    s_stats.CleansByArea = 0;
+    s_stats.CleansByTime = 0;
+}
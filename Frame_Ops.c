@@ -0,0 +1,307 @@
+/*****************************************************************************
+ * | File      	:   Frame_Ops.c
+ * | Author      :
+ * | Function    :   Word-at-a-time kernels for 1bpp frame buffers
+ * | Info        :
+ *   Every kernel works bytewise up to a 4-byte boundary of its destination,
+ *   then 32 bits at a time, then bytewise over the tail. A source that is
+ *   not aligned with the destination is read through memcpy.
+ *----------------
+ * |	This version:   V1.0
+ * | Date        :
+ * | Info        :
+ * -----------------------------------------------------------------------------
+ ******************************************************************************/
+#include "Frame_Ops.h"
+#include <stdint.h>
+#include <string.h>
+
+// Word access to byte buffers, allowed to alias them
+typedef uint32_t __attribute__((may_alias)) FRAME_WORD;
+
+#define FRAME_ALIGNED(p) (((uintptr_t)(p) & 3) == 0)
+
+/******************************************************************************
+function :	Read one word from a source of any alignment
+parameter:
+    Src : Source bytes
+******************************************************************************/
+static inline uint32_t Frame_Load(const UBYTE *Src)
+{
+    uint32_t w;
+    memcpy(&w, Src, 4);
+    return w;
+}
+
+/******************************************************************************
+function :	Fill a buffer with one byte value
+parameter:
+    Dst   : Buffer
+    Value : Byte written everywhere
+    Len   : Bytes
+******************************************************************************/
+void Frame_Fill(UBYTE *Dst, UBYTE Value, UDOUBLE Len)
+{
+    for (; Len && !FRAME_ALIGNED(Dst); Len--)
+    {
+        *Dst++ = Value;
+    }
+
+    uint32_t W = Value * 0x01010101u;
+    FRAME_WORD *D = (FRAME_WORD *)Dst;
+    for (; Len >= 16; Len -= 16, D += 4)
+    {
+        D[0] = W;
+        D[1] = W;
+        D[2] = W;
+        D[3] = W;
+    }
+    for (; Len >= 4; Len -= 4)
+    {
+        *D++ = W;
+    }
+
+    Dst = (UBYTE *)D;
+    while (Len--)
+    {
+        *Dst++ = Value;
+    }
+}
+
+/******************************************************************************
+function :	Invert every bit of a buffer
+parameter:
+    Dst : Buffer
+    Len : Bytes
+******************************************************************************/
+void Frame_Invert(UBYTE *Dst, UDOUBLE Len)
+{
+    for (; Len && !FRAME_ALIGNED(Dst); Len--, Dst++)
+    {
+        *Dst = ~*Dst;
+    }
+
+    FRAME_WORD *D = (FRAME_WORD *)Dst;
+    for (; Len >= 4; Len -= 4, D++)
+    {
+        *D = ~*D;
+    }
+
+    for (Dst = (UBYTE *)D; Len; Len--, Dst++)
+    {
+        *Dst = ~*Dst;
+    }
+}
+
+/******************************************************************************
+function :	Combine a source into a buffer word by word
+parameter:
+    Dst : Buffer, updated
+    Src : Source, must not overlap Dst
+    Len : Bytes
+    OP  : Expression of D (destination word) and S (source word)
+******************************************************************************/
+#define FRAME_COMBINE(Dst, Src, Len, OP)                              \
+    do                                                                \
+    {                                                                 \
+        for (; Len && !FRAME_ALIGNED(Dst); Len--, Dst++, Src++)       \
+        {                                                             \
+            UBYTE D = *Dst, S = *Src;                                 \
+            *Dst = (UBYTE)(OP);                                       \
+        }                                                             \
+        FRAME_WORD *Dw = (FRAME_WORD *)Dst;                           \
+        if (FRAME_ALIGNED(Src))                                       \
+        {                                                             \
+            const FRAME_WORD *Sw = (const FRAME_WORD *)Src;           \
+            for (; Len >= 4; Len -= 4, Dw++, Sw++)                    \
+            {                                                         \
+                uint32_t D = *Dw, S = *Sw;                            \
+                *Dw = (OP);                                           \
+            }                                                         \
+            Src = (const UBYTE *)Sw;                                  \
+        }                                                             \
+        else                                                          \
+        {                                                             \
+            for (; Len >= 4; Len -= 4, Dw++, Src += 4)                \
+            {                                                         \
+                uint32_t D = *Dw, S = Frame_Load(Src);                \
+                *Dw = (OP);                                           \
+            }                                                         \
+        }                                                             \
+        for (Dst = (UBYTE *)Dw; Len; Len--, Dst++, Src++)             \
+        {                                                             \
+            UBYTE D = *Dst, S = *Src;                                 \
+            *Dst = (UBYTE)(OP);                                       \
+        }                                                             \
+    } while (0)
+
+/******************************************************************************
+function :	Copy a buffer
+parameter:
+    Dst : Destination
+    Src : Source, must not overlap Dst
+    Len : Bytes
+Info:
+    Falls back to memcpy when the two are not aligned alike.
+******************************************************************************/
+void Frame_Copy(UBYTE *Dst, const UBYTE *Src, UDOUBLE Len)
+{
+    if (((uintptr_t)Dst & 3) != ((uintptr_t)Src & 3))
+    {
+        memcpy(Dst, Src, Len);
+        return;
+    }
+    for (; Len && !FRAME_ALIGNED(Dst); Len--)
+    {
+        *Dst++ = *Src++;
+    }
+
+    FRAME_WORD *D = (FRAME_WORD *)Dst;
+    const FRAME_WORD *S = (const FRAME_WORD *)Src;
+    for (; Len >= 16; Len -= 16, D += 4, S += 4)
+    {
+        D[0] = S[0];
+        D[1] = S[1];
+        D[2] = S[2];
+        D[3] = S[3];
+    }
+    for (; Len >= 4; Len -= 4)
+    {
+        *D++ = *S++;
+    }
+
+    Dst = (UBYTE *)D;
+    Src = (const UBYTE *)S;
+    while (Len--)
+    {
+        *Dst++ = *Src++;
+    }
+}
+
+/******************************************************************************
+function :	XOR a source into a buffer, leaving the changed bits set
+parameter:
+    Dst : Buffer, updated
+    Src : Source
+    Len : Bytes
+******************************************************************************/
+void Frame_Xor(UBYTE *Dst, const UBYTE *Src, UDOUBLE Len)
+{
+    FRAME_COMBINE(Dst, Src, Len, D ^ S);
+}
+
+/******************************************************************************
+function :	OR a source into a buffer
+parameter:
+    Dst : Buffer, updated
+    Src : Source
+    Len : Bytes
+******************************************************************************/
+void Frame_Or(UBYTE *Dst, const UBYTE *Src, UDOUBLE Len)
+{
+    FRAME_COMBINE(Dst, Src, Len, D | S);
+}
+
+/******************************************************************************
+function :	Count the bits set in a buffer, or in the XOR of two buffers
+parameter:
+    A   : Buffer
+    B   : Second buffer, NULL to count A alone
+    Len : Bytes
+Info:
+    Per-byte counts of up to 31 words are summed side by side before they
+    are added up, one multiply per 31 words.
+******************************************************************************/
+static UDOUBLE Frame_CountBits(const UBYTE *A, const UBYTE *B, UDOUBLE Len)
+{
+    UDOUBLE Total = 0;
+    for (; Len && !FRAME_ALIGNED(A); Len--, A++)
+    {
+        Total += Frame_Popcount32(B ? (UBYTE)(*A ^ *B++) : *A);
+    }
+
+    const FRAME_WORD *Aw = (const FRAME_WORD *)A;
+    while (Len >= 4)
+    {
+        uint32_t Sum = 0; // Four byte lanes of at most 31 * 8
+        for (UBYTE n = 0; n < 31 && Len >= 4; n++, Len -= 4, Aw++)
+        {
+            uint32_t x = *Aw;
+            if (B)
+            {
+                x ^= Frame_Load(B);
+                B += 4;
+            }
+            x = x - ((x >> 1) & 0x55555555);
+            x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+            Sum += (x + (x >> 4)) & 0x0F0F0F0F;
+        }
+        Sum = (Sum & 0x00FF00FF) + ((Sum >> 8) & 0x00FF00FF);
+        Total += (Sum & 0xFFFF) + (Sum >> 16);
+    }
+
+    for (A = (const UBYTE *)Aw; Len; Len--, A++)
+    {
+        Total += Frame_Popcount32(B ? (UBYTE)(*A ^ *B++) : *A);
+    }
+    return Total;
+}
+
+/******************************************************************************
+function :	Count the bits set in a buffer
+parameter:
+    Src : Buffer
+    Len : Bytes
+******************************************************************************/
+UDOUBLE Frame_Popcount(const UBYTE *Src, UDOUBLE Len)
+{
+    return Frame_CountBits(Src, NULL, Len);
+}
+
+/******************************************************************************
+function :	Count the bits that differ between two buffers
+parameter:
+    A, B : Buffers
+    Len  : Bytes
+******************************************************************************/
+UDOUBLE Frame_DiffCount(const UBYTE *A, const UBYTE *B, UDOUBLE Len)
+{
+    return Frame_CountBits(A, B, Len);
+}
+
+/******************************************************************************
+function :	Find the first and last byte where two buffers differ
+parameter:
+    A, B  : Buffers
+    Len   : Bytes
+    First : First differing byte
+    Last  : Last differing byte
+Info:
+    Returns 0 if the buffers are equal. Scans forward to the first
+    difference and backward to the last one, a word at a time.
+******************************************************************************/
+UBYTE Frame_DiffRange(const UBYTE *A, const UBYTE *B, UDOUBLE Len, UDOUBLE *First, UDOUBLE *Last)
+{
+    UDOUBLE i = 0;
+    for (; i + 4 <= Len; i += 4)
+    {
+        if (Frame_Load(A + i) != Frame_Load(B + i))
+            break;
+    }
+    for (; i < Len && A[i] == B[i]; i++)
+        ;
+    if (i == Len)
+        return 0;
+    *First = i;
+
+    UDOUBLE j = Len;
+    for (; j >= i + 4; j -= 4)
+    {
+        if (Frame_Load(A + j - 4) != Frame_Load(B + j - 4))
+            break;
+    }
+    while (A[j - 1] == B[j - 1])
+        j--;
+    *Last = j - 1;
+    return 1;
+}
@@ -0,0 +1,604 @@
+/*****************************************************************************
+ * | File      	:   GUI_DisplayList.c
+ * | Author      :
+ * | Function    :   Record Paint calls and replay them band by band
+ * | Info        :
+ *   Commands are packed one after another in the list buffer: a DLIST_CMD
+ *   header, its int32 arguments, then any copied payload. Replaying selects
+ *   the band with Paint_SelectBand, so every call is clipped to the rows
+ *   held in the band and draws exactly the pixels it draws on a full frame.
+ *----------------
+ * |	This version:   V1.0
+ * | Date        :
+ * | Info        :
+ * -----------------------------------------------------------------------------
+ ******************************************************************************/
+#include "GUI_DisplayList.h"
+#include "Debug.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "DLIST";
+
+#define DLIST_PARALLEL_STACK 4096 // Helper task, deep enough for any Paint call
+
+typedef enum
+{
+    DLIST_OP_CLEAR = 0,
+    DLIST_OP_CLEAR_WINDOWS,
+    DLIST_OP_PUSH_CLIP,
+    DLIST_OP_POP_CLIP,
+    DLIST_OP_PIXEL,
+    DLIST_OP_POINT,
+    DLIST_OP_LINE,
+    DLIST_OP_LINE_CAP,
+    DLIST_OP_RECTANGLE,
+    DLIST_OP_CIRCLE,
+    DLIST_OP_ELLIPSE,
+    DLIST_OP_ROUND_RECT,
+    DLIST_OP_ARC,
+    DLIST_OP_TRIANGLE,
+    DLIST_OP_POLYGON,
+    DLIST_OP_FILL_POLYGON,
+    DLIST_OP_CHAR,
+    DLIST_OP_STRING,
+    DLIST_OP_NUM,
+    DLIST_OP_BITMAP,
+    DLIST_OP_BLIT,
+} DLIST_OP;
+
+/**
+ * Command header, followed by Args int32 arguments and Extra payload bytes
+ **/
+typedef struct
+{
+    UBYTE Op;
+    UBYTE Args;
+    UBYTE Style[2]; // Line width and style, cap, fill, character or raster operation
+    UWORD Color[2]; // Color, then text background
+    UWORD Size;     // Bytes up to the next command, a multiple of 4
+    UWORD Extra;
+} DLIST_CMD;
+
+#define DLIST_ARG(Cmd) ((int32_t *)((Cmd) + 1))
+#define DLIST_EXTRA(Cmd) ((UBYTE *)(DLIST_ARG(Cmd) + (Cmd)->Args))
+
+/******************************************************************************
+function :	Allocate an empty display list
+parameter:
+    List   : List to set up
+    Size   : Bytes for commands, a line takes 28, a string 20 plus its length
+    Width  : Image width, as for Paint_NewImage
+    Height : Image height
+    Rotate : Rotation the commands are drawn with
+Info:
+    Returns 1 if the buffer can't be allocated.
+******************************************************************************/
+UBYTE DList_Init(PAINT_DLIST *List, UDOUBLE Size, UWORD Width, UWORD Height, UWORD Rotate)
+{
+    memset(List, 0, sizeof(*List));
+    List->Buffer = (UBYTE *)malloc(Size);
+    if (List->Buffer == NULL)
+    {
+        ESP_LOGE(TAG, "Failed to allocate %lu bytes for the display list", (unsigned long)Size);
+        return 1;
+    }
+    List->Size = Size;
+    List->Width = Width;
+    List->Height = Height;
+    List->Rotate = Rotate;
+    return 0;
+}
+
+void DList_Free(PAINT_DLIST *List)
+{
+    free(List->Buffer);
+    memset(List, 0, sizeof(*List));
+}
+
+/******************************************************************************
+function :	Drop every recorded command
+parameter:
+    List : Display list
+******************************************************************************/
+void DList_Reset(PAINT_DLIST *List)
+{
+    List->Used = 0;
+    List->Count = 0;
+    List->Overflow = 0;
+}
+
+/******************************************************************************
+function :	Reserve a command at the end of the list
+parameter:
+    List  : Display list
+    Op    : DLIST_OP_*
+    Args  : Arguments to store
+    Count : Number of arguments
+    Extra : Payload bytes, left zeroed for the caller
+Info:
+    Returns NULL and sets Overflow when the list is full.
+******************************************************************************/
+static DLIST_CMD *DList_Append(PAINT_DLIST *List, UBYTE Op, const int *Args, UBYTE Count, UDOUBLE Extra)
+{
+    UDOUBLE Size = (sizeof(DLIST_CMD) + Count * sizeof(int32_t) + Extra + 3) & ~(UDOUBLE)3;
+    if (List->Buffer == NULL || Size > 0xFFFF || List->Used + Size > List->Size)
+    {
+        if (!List->Overflow)
+        {
+            ESP_LOGW(TAG, "Display list full (%lu of %lu bytes), command dropped",
+                     (unsigned long)List->Used, (unsigned long)List->Size);
+        }
+        List->Overflow = 1;
+        return NULL;
+    }
+
+    DLIST_CMD *Cmd = (DLIST_CMD *)&List->Buffer[List->Used];
+    memset(Cmd, 0, Size);
+    Cmd->Op = Op;
+    Cmd->Args = Count;
+    Cmd->Size = (UWORD)Size;
+    Cmd->Extra = (UWORD)Extra;
+    for (UBYTE i = 0; i < Count; i++)
+    {
+        DLIST_ARG(Cmd)[i] = Args[i];
+    }
+    List->Used += Size;
+    List->Count++;
+    return Cmd;
+}
+
+/******************************************************************************
+function :	Record a command made of arguments, one color and two styles
+parameter:
+******************************************************************************/
+static UBYTE DList_Shape(PAINT_DLIST *List, UBYTE Op, const int *Args, UBYTE Count,
+                         UWORD Color, UBYTE Style0, UBYTE Style1)
+{
+    DLIST_CMD *Cmd = DList_Append(List, Op, Args, Count, 0);
+    if (Cmd == NULL)
+        return 1;
+    Cmd->Color[0] = Color;
+    Cmd->Style[0] = Style0;
+    Cmd->Style[1] = Style1;
+    return 0;
+}
+
+/******************************************************************************
+function :	Record a command that keeps a pointer, plus optional copied bytes
+parameter:
+******************************************************************************/
+static DLIST_CMD *DList_Pointer(PAINT_DLIST *List, UBYTE Op, const int *Args, UBYTE Count,
+                                const void *Ptr, const void *Data, UDOUBLE Len)
+{
+    DLIST_CMD *Cmd = DList_Append(List, Op, Args, Count, sizeof(Ptr) + Len);
+    if (Cmd == NULL)
+        return NULL;
+    memcpy(DLIST_EXTRA(Cmd), &Ptr, sizeof(Ptr));
+    if (Len)
+        memcpy(DLIST_EXTRA(Cmd) + sizeof(Ptr), Data, Len);
+    return Cmd;
+}
+
+UBYTE DList_Clear(PAINT_DLIST *List, UWORD Color)
+{
+    return DList_Shape(List, DLIST_OP_CLEAR, NULL, 0, Color, 0, 0);
+}
+
+UBYTE DList_ClearWindows(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color)
+{
+    int Args[] = {Xstart, Ystart, Xend, Yend};
+    return DList_Shape(List, DLIST_OP_CLEAR_WINDOWS, Args, 4, Color, 0, 0);
+}
+
+UBYTE DList_PushClip(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend)
+{
+    int Args[] = {Xstart, Ystart, Xend, Yend};
+    return DList_Shape(List, DLIST_OP_PUSH_CLIP, Args, 4, 0, 0, 0);
+}
+
+UBYTE DList_PopClip(PAINT_DLIST *List)
+{
+    return DList_Shape(List, DLIST_OP_POP_CLIP, NULL, 0, 0, 0, 0);
+}
+
+UBYTE DList_SetPixel(PAINT_DLIST *List, int Xpoint, int Ypoint, UWORD Color)
+{
+    int Args[] = {Xpoint, Ypoint};
+    return DList_Shape(List, DLIST_OP_PIXEL, Args, 2, Color, 0, 0);
+}
+
+UBYTE DList_DrawPoint(PAINT_DLIST *List, int Xpoint, int Ypoint, UWORD Color,
+                      DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay)
+{
+    int Args[] = {Xpoint, Ypoint};
+    return DList_Shape(List, DLIST_OP_POINT, Args, 2, Color, Dot_Pixel, Dot_FillWay);
+}
+
+UBYTE DList_DrawLine(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color,
+                     DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    int Args[] = {Xstart, Ystart, Xend, Yend};
+    return DList_Shape(List, DLIST_OP_LINE, Args, 4, Color, Line_width, Line_Style);
+}
+
+UBYTE DList_DrawLineCap(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color,
+                        DOT_PIXEL Line_width, LINE_CAP Line_Cap)
+{
+    int Args[] = {Xstart, Ystart, Xend, Yend};
+    return DList_Shape(List, DLIST_OP_LINE_CAP, Args, 4, Color, Line_width, Line_Cap);
+}
+
+UBYTE DList_DrawRectangle(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color,
+                          DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Args[] = {Xstart, Ystart, Xend, Yend};
+    return DList_Shape(List, DLIST_OP_RECTANGLE, Args, 4, Color, Line_width, Draw_Fill);
+}
+
+UBYTE DList_DrawCircle(PAINT_DLIST *List, int X_Center, int Y_Center, int Radius, UWORD Color,
+                       DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Args[] = {X_Center, Y_Center, Radius};
+    return DList_Shape(List, DLIST_OP_CIRCLE, Args, 3, Color, Line_width, Draw_Fill);
+}
+
+UBYTE DList_DrawEllipse(PAINT_DLIST *List, int X_Center, int Y_Center, int X_Radius, int Y_Radius, UWORD Color,
+                        DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Args[] = {X_Center, Y_Center, X_Radius, Y_Radius};
+    return DList_Shape(List, DLIST_OP_ELLIPSE, Args, 4, Color, Line_width, Draw_Fill);
+}
+
+UBYTE DList_DrawRoundRect(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, int Radius, UWORD Color,
+                          DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Args[] = {Xstart, Ystart, Xend, Yend, Radius};
+    return DList_Shape(List, DLIST_OP_ROUND_RECT, Args, 5, Color, Line_width, Draw_Fill);
+}
+
+UBYTE DList_DrawArc(PAINT_DLIST *List, int X_Center, int Y_Center, int Radius, int Start_Angle, int End_Angle,
+                    UWORD Color, DOT_PIXEL Line_width)
+{
+    int Args[] = {X_Center, Y_Center, Radius, Start_Angle, End_Angle};
+    return DList_Shape(List, DLIST_OP_ARC, Args, 5, Color, Line_width, 0);
+}
+
+UBYTE DList_FillTriangle(PAINT_DLIST *List, int X0, int Y0, int X1, int Y1, int X2, int Y2, UWORD Color)
+{
+    int Args[] = {X0, Y0, X1, Y1, X2, Y2};
+    return DList_Shape(List, DLIST_OP_TRIANGLE, Args, 6, Color, 0, 0);
+}
+
+/******************************************************************************
+function :	Record a polygon, the points are copied into the list
+parameter:
+******************************************************************************/
+static UBYTE DList_Points(PAINT_DLIST *List, UBYTE Op, const PAINT_POINT *Points, UWORD Count,
+                          UWORD Color, UBYTE Line_width)
+{
+    DLIST_CMD *Cmd = DList_Append(List, Op, NULL, 0, (UDOUBLE)Count * sizeof(PAINT_POINT));
+    if (Cmd == NULL)
+        return 1;
+    memcpy(DLIST_EXTRA(Cmd), Points, (UDOUBLE)Count * sizeof(PAINT_POINT));
+    Cmd->Color[0] = Color;
+    Cmd->Style[0] = Line_width;
+    return 0;
+}
+
+UBYTE DList_DrawPolygon(PAINT_DLIST *List, const PAINT_POINT *Points, UWORD Count, UWORD Color, DOT_PIXEL Line_width)
+{
+    return DList_Points(List, DLIST_OP_POLYGON, Points, Count, Color, Line_width);
+}
+
+UBYTE DList_FillPolygon(PAINT_DLIST *List, const PAINT_POINT *Points, UWORD Count, UWORD Color)
+{
+    return DList_Points(List, DLIST_OP_FILL_POLYGON, Points, Count, Color, 0);
+}
+
+UBYTE DList_DrawChar(PAINT_DLIST *List, int Xpoint, int Ypoint, const char Acsii_Char, sFONT *Font,
+                     UWORD Color_Foreground, UWORD Color_Background)
+{
+    int Args[] = {Xpoint, Ypoint};
+    DLIST_CMD *Cmd = DList_Pointer(List, DLIST_OP_CHAR, Args, 2, Font, NULL, 0);
+    if (Cmd == NULL)
+        return 1;
+    Cmd->Style[0] = (UBYTE)Acsii_Char;
+    Cmd->Color[0] = Color_Foreground;
+    Cmd->Color[1] = Color_Background;
+    return 0;
+}
+
+UBYTE DList_DrawString(PAINT_DLIST *List, int Xstart, int Ystart, const char *pString, sFONT *Font,
+                       UWORD Color_Foreground, UWORD Color_Background)
+{
+    int Args[] = {Xstart, Ystart};
+    DLIST_CMD *Cmd = DList_Pointer(List, DLIST_OP_STRING, Args, 2, Font, pString, strlen(pString) + 1);
+    if (Cmd == NULL)
+        return 1;
+    Cmd->Color[0] = Color_Foreground;
+    Cmd->Color[1] = Color_Background;
+    return 0;
+}
+
+UBYTE DList_DrawNum(PAINT_DLIST *List, UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT *Font,
+                    UWORD Color_Foreground, UWORD Color_Background)
+{
+    int Args[] = {Xpoint, Ypoint, Nummber};
+    DLIST_CMD *Cmd = DList_Pointer(List, DLIST_OP_NUM, Args, 3, Font, NULL, 0);
+    if (Cmd == NULL)
+        return 1;
+    Cmd->Color[0] = Color_Foreground;
+    Cmd->Color[1] = Color_Background;
+    return 0;
+}
+
+UBYTE DList_DrawBitMap(PAINT_DLIST *List, const unsigned char *image_buffer)
+{
+    return DList_Pointer(List, DLIST_OP_BITMAP, NULL, 0, image_buffer, NULL, 0) ? 0 : 1;
+}
+
+UBYTE DList_Blit(PAINT_DLIST *List, int Xpoint, int Ypoint, UWORD Width, UWORD Height,
+                 const UBYTE *Src, UWORD Stride, PAINT_ROP Rop)
+{
+    int Args[] = {Xpoint, Ypoint, Width, Height, Stride};
+    DLIST_CMD *Cmd = DList_Pointer(List, DLIST_OP_BLIT, Args, 5, Src, NULL, 0);
+    if (Cmd == NULL)
+        return 1;
+    Cmd->Style[0] = (UBYTE)Rop;
+    return 0;
+}
+
+/******************************************************************************
+function :	Run one recorded command through Paint
+parameter:
+    P   : Paint context selecting the band
+    Cmd : Command
+******************************************************************************/
+static void DList_Replay(PAINT *P, const DLIST_CMD *Cmd)
+{
+    const int32_t *A = DLIST_ARG(Cmd);
+    const UBYTE *E = DLIST_EXTRA(Cmd);
+    const void *Ptr = NULL;
+
+    switch (Cmd->Op)
+    {
+    case DLIST_OP_CHAR:
+    case DLIST_OP_STRING:
+    case DLIST_OP_NUM:
+    case DLIST_OP_BITMAP:
+    case DLIST_OP_BLIT:
+        memcpy(&Ptr, E, sizeof(Ptr));
+        break;
+    default:
+        break;
+    }
+
+    switch (Cmd->Op)
+    {
+    case DLIST_OP_CLEAR:
+        Paint_ClearWindows_S_Ctx(P, 0, 0, P->Width, P->Height, Cmd->Color[0]);
+        break;
+    case DLIST_OP_CLEAR_WINDOWS:
+        Paint_ClearWindows_S_Ctx(P, A[0], A[1], A[2], A[3], Cmd->Color[0]);
+        break;
+    case DLIST_OP_PUSH_CLIP:
+        Paint_PushClip_Ctx(P, A[0], A[1], A[2], A[3]);
+        break;
+    case DLIST_OP_POP_CLIP:
+        Paint_PopClip_Ctx(P);
+        break;
+    case DLIST_OP_PIXEL:
+        Paint_SetPixel_S_Ctx(P, A[0], A[1], Cmd->Color[0]);
+        break;
+    case DLIST_OP_POINT:
+        Paint_DrawPoint_S_Ctx(P, A[0], A[1], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (DOT_STYLE)Cmd->Style[1]);
+        break;
+    case DLIST_OP_LINE:
+        Paint_DrawLine_S_Ctx(P, A[0], A[1], A[2], A[3], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (LINE_STYLE)Cmd->Style[1]);
+        break;
+    case DLIST_OP_LINE_CAP:
+        Paint_DrawLineCap_S_Ctx(P, A[0], A[1], A[2], A[3], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (LINE_CAP)Cmd->Style[1]);
+        break;
+    case DLIST_OP_RECTANGLE:
+        Paint_DrawRectangle_S_Ctx(P, A[0], A[1], A[2], A[3], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (DRAW_FILL)Cmd->Style[1]);
+        break;
+    case DLIST_OP_CIRCLE:
+        Paint_DrawCircle_S_Ctx(P, A[0], A[1], A[2], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (DRAW_FILL)Cmd->Style[1]);
+        break;
+    case DLIST_OP_ELLIPSE:
+        Paint_DrawEllipse_S_Ctx(P, A[0], A[1], A[2], A[3], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (DRAW_FILL)Cmd->Style[1]);
+        break;
+    case DLIST_OP_ROUND_RECT:
+        Paint_DrawRoundRect_Ctx(P, A[0], A[1], A[2], A[3], A[4], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0], (DRAW_FILL)Cmd->Style[1]);
+        break;
+    case DLIST_OP_ARC:
+        Paint_DrawArc_Ctx(P, A[0], A[1], A[2], A[3], A[4], Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0]);
+        break;
+    case DLIST_OP_TRIANGLE:
+        Paint_FillTriangle_Ctx(P, A[0], A[1], A[2], A[3], A[4], A[5], Cmd->Color[0]);
+        break;
+    case DLIST_OP_POLYGON:
+        Paint_DrawPolygon_Ctx(P, (const PAINT_POINT *)E, Cmd->Extra / sizeof(PAINT_POINT), Cmd->Color[0], (DOT_PIXEL)Cmd->Style[0]);
+        break;
+    case DLIST_OP_FILL_POLYGON:
+        Paint_FillPolygon_Ctx(P, (const PAINT_POINT *)E, Cmd->Extra / sizeof(PAINT_POINT), Cmd->Color[0]);
+        break;
+    case DLIST_OP_CHAR:
+        Paint_DrawChar_S_Ctx(P, A[0], A[1], (char)Cmd->Style[0], (sFONT *)Ptr, Cmd->Color[0], Cmd->Color[1]);
+        break;
+    case DLIST_OP_STRING:
+        Paint_DrawString_S_Ctx(P, A[0], A[1], (const char *)E + sizeof(Ptr), (sFONT *)Ptr, Cmd->Color[0], Cmd->Color[1]);
+        break;
+    case DLIST_OP_NUM:
+        Paint_DrawNum_Ctx(P, A[0], A[1], A[2], (sFONT *)Ptr, Cmd->Color[0], Cmd->Color[1]);
+        break;
+    case DLIST_OP_BITMAP:
+        Paint_DrawBitMap_Ctx(P, (const unsigned char *)Ptr);
+        break;
+    case DLIST_OP_BLIT:
+        Paint_Blit_Ctx(P, A[0], A[1], A[2], A[3], (const UBYTE *)Ptr, A[4], (PAINT_ROP)Cmd->Style[0]);
+        break;
+    default:
+        break;
+    }
+}
+
+/******************************************************************************
+function :	Rasterize part of the recorded frame into a band buffer
+parameter:
+    Band   : DLIST_BAND_BYTES(List, Rows) bytes
+    Ystart : First image memory row of the band
+    Rows   : Memory rows in the band
+    Ctx    : The PAINT_DLIST
+Info:
+    The band starts white and gets every command, clipped to its rows. It
+    is drawn through its own Paint context, so bands can be rendered on
+    several tasks at once. Matches the EPD_2IN13_BAND_FN callback, returns
+    1 if the list overflowed.
+******************************************************************************/
+UBYTE DList_RenderBand(UBYTE *Band, UWORD Ystart, UWORD Rows, void *Ctx)
+{
+    const PAINT_DLIST *List = (const PAINT_DLIST *)Ctx;
+    if (List == NULL || List->Buffer == NULL || Band == NULL)
+    {
+        ESP_LOGE(TAG, "Nothing to render");
+        return 1;
+    }
+    if (List->Overflow)
+    {
+        ESP_LOGE(TAG, "Display list overflowed, frame is incomplete");
+        return 1;
+    }
+
+    PAINT Context;
+    memset(&Context, 0, sizeof(Context));
+    Paint_NewImage_Ctx(&Context, Band, List->Width, List->Height, List->Rotate, WHITE);
+    Paint_SelectBand_Ctx(&Context, Band, Ystart, Rows);
+    memset(Band, 0xFF, DLIST_BAND_BYTES(List, Rows));
+
+    for (UDOUBLE Pos = 0; Pos < List->Used;)
+    {
+        const DLIST_CMD *Cmd = (const DLIST_CMD *)&List->Buffer[Pos];
+        DList_Replay(&Context, Cmd);
+        Pos += Cmd->Size;
+    }
+    return 0;
+}
+
+/**
+ * Frame shared by the workers of DList_RenderParallel
+ **/
+typedef struct
+{
+    const PAINT_DLIST *List;
+    UBYTE *Image;
+    UWORD BandRows;
+    UWORD Bands;
+    UWORD Next;   // Band queue, the next band nobody has taken
+    UBYTE Failed;
+    SemaphoreHandle_t Done; // Given by the helper once the queue is empty
+} DLIST_PARALLEL;
+
+/******************************************************************************
+function :	Take bands off the queue and rasterize them until none is left
+parameter:
+    Job : Frame being rendered
+Info:
+    Bands own separate rows of the image, so workers never write the same
+    byte and finish in whatever order they run.
+******************************************************************************/
+static void DList_RenderWorker(DLIST_PARALLEL *Job)
+{
+    UDOUBLE RowBytes = DLIST_BAND_BYTES(Job->List, 1);
+    for (;;)
+    {
+        UWORD Band = __atomic_fetch_add(&Job->Next, 1, __ATOMIC_RELAXED);
+        if (Band >= Job->Bands)
+        {
+            return;
+        }
+        UWORD Ystart = Band * Job->BandRows;
+        UWORD Rows = (Job->List->Height - Ystart < Job->BandRows) ? (Job->List->Height - Ystart) : Job->BandRows;
+        if (DList_RenderBand(&Job->Image[Ystart * RowBytes], Ystart, Rows, (void *)Job->List) != 0)
+        {
+            __atomic_store_n(&Job->Failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+#if portNUM_PROCESSORS > 1
+static void DList_RenderTask(void *Arg)
+{
+    DLIST_PARALLEL *Job = (DLIST_PARALLEL *)Arg;
+    DList_RenderWorker(Job);
+    xSemaphoreGive(Job->Done); // Job lives on the caller's stack, don't touch it after this
+    vTaskDelete(NULL);
+}
+#endif
+
+/******************************************************************************
+function :	Rasterize the whole recorded frame on every core
+parameter:
+    List     : Recorded frame
+    Image    : DLIST_BAND_BYTES(List, List->Height) bytes, gets the frame
+    BandRows : Memory rows per band, 0 for 16
+Info:
+    The image is cut into bands that the caller and a helper task on the
+    other core take from a shared queue, so a core that draws cheap bands
+    simply takes more of them. Every band is clipped to its rows as in
+    DList_RenderBand and the image is bit-identical to a serial render. On
+    single-core parts, or if the helper can't be started, the caller renders
+    every band itself. Returns 1 if the list overflowed.
+******************************************************************************/
+UBYTE DList_RenderParallel(const PAINT_DLIST *List, UBYTE *Image, UWORD BandRows)
+{
+    if (List == NULL || List->Buffer == NULL || Image == NULL)
+    {
+        ESP_LOGE(TAG, "Nothing to render");
+        return 1;
+    }
+    if (List->Overflow)
+    {
+        ESP_LOGE(TAG, "Display list overflowed, frame is incomplete");
+        return 1;
+    }
+
+    DLIST_PARALLEL Job;
+    memset(&Job, 0, sizeof(Job));
+    Job.List = List;
+    Job.Image = Image;
+    Job.BandRows = BandRows ? BandRows : 16;
+    Job.Bands = (List->Height + Job.BandRows - 1) / Job.BandRows;
+
+#if portNUM_PROCESSORS > 1
+    StaticSemaphore_t DoneBuffer;
+    TaskHandle_t Helper = NULL;
+    if (Job.Bands > 1)
+    {
+        Job.Done = xSemaphoreCreateBinaryStatic(&DoneBuffer);
+        if (xTaskCreatePinnedToCore(DList_RenderTask, "dlist_render", DLIST_PARALLEL_STACK, &Job,
+                                    uxTaskPriorityGet(NULL), &Helper, 1 - xPortGetCoreID()) != pdPASS)
+        {
+            ESP_LOGW(TAG, "No helper task, rendering on one core");
+            Helper = NULL;
+        }
+    }
+    DList_RenderWorker(&Job);
+    if (Helper != NULL)
+    {
+        xSemaphoreTake(Job.Done, portMAX_DELAY);
+    }
+    if (Job.Done != NULL)
+    {
+        vSemaphoreDelete(Job.Done);
+    }
+#else
+    DList_RenderWorker(&Job);
+#endif
+    return Job.Failed;
+}
@@ -16,6 +16,7 @@
 #include "GUI_Paint.h"
 #include "DEV_Config.h"
 #include "Debug.h"
+#include "Frame_Ops.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h> //memset()
@@ -25,6 +26,130 @@ static const char *TAG = "GUI_PAINT";
 
 PAINT Paint;
 
+/******************************************************************************
+function: Pixel writers, one per memory transform and scale
+info:
+    Rotation and mirror together always reduce to an optional X/Y swap
+    followed by optional X and Y flips, so 8 transforms x 3 scales cover
+    every setting. Each writer is specialized at compile time and checks
+    the point against the clip rectangle. Paint_UpdateWriter picks the one
+    in use.
+******************************************************************************/
+// Start of image memory row Y, Image holds the rows from ImageRow on
+#define PAINT_ROW(P, Y) (&(P)->Image[(UDOUBLE)((Y) - (P)->ImageRow) * (P)->WidthByte])
+
+#define PAINT_PUT_1BPP(P, X, Y, Color)                           \
+    do                                                           \
+    {                                                            \
+        UBYTE *Byte = &PAINT_ROW(P, Y)[(X) / 8];                 \
+        if ((Color) == BLACK)                                    \
+            *Byte &= ~(0x80 >> ((X) % 8));                       \
+        else                                                     \
+            *Byte |= (0x80 >> ((X) % 8));                        \
+    } while (0)
+
+#define PAINT_PUT_2BPP(P, X, Y, Color)                           \
+    do                                                           \
+    {                                                            \
+        UBYTE *Byte = &PAINT_ROW(P, Y)[(X) / 4];                 \
+        UBYTE Shift = 6 - ((X) % 4) * 2;                         \
+        *Byte = (*Byte & ~(0x03 << Shift)) | (((Color) % 4) << Shift); \
+    } while (0)
+
+#define PAINT_PUT_4BPP(P, X, Y, Color)                           \
+    do                                                           \
+    {                                                            \
+        UBYTE *Byte = &PAINT_ROW(P, Y)[(X) / 2];                 \
+        UBYTE Shift = 4 - ((X) % 2) * 4;                         \
+        *Byte = (*Byte & ~(0x0F << Shift)) | (((Color) & 0x0F) << Shift); \
+    } while (0)
+
+#define PAINT_WRITER(NAME, SWAP, FLIPX, FLIPY, PUT)                       \
+    static void NAME(const PAINT *P, UWORD Xpoint, UWORD Ypoint, UWORD Color) \
+    {                                                                     \
+        if (Xpoint < P->Clip.Xstart || Xpoint >= P->Clip.Xend ||          \
+            Ypoint < P->Clip.Ystart || Ypoint >= P->Clip.Yend)            \
+            return;                                                       \
+        UWORD X = (SWAP) ? Ypoint : Xpoint;                               \
+        UWORD Y = (SWAP) ? Xpoint : Ypoint;                               \
+        if (FLIPX)                                                        \
+            X = P->WidthMemory - X - 1;                                   \
+        if (FLIPY)                                                        \
+            Y = P->HeightMemory - Y - 1;                                  \
+        PUT(P, X, Y, Color);                                              \
+    }
+
+#define PAINT_WRITERS(SUFFIX, PUT)                        \
+    PAINT_WRITER(Paint_Put_000_##SUFFIX, 0, 0, 0, PUT)    \
+    PAINT_WRITER(Paint_Put_001_##SUFFIX, 0, 0, 1, PUT)    \
+    PAINT_WRITER(Paint_Put_010_##SUFFIX, 0, 1, 0, PUT)    \
+    PAINT_WRITER(Paint_Put_011_##SUFFIX, 0, 1, 1, PUT)    \
+    PAINT_WRITER(Paint_Put_100_##SUFFIX, 1, 0, 0, PUT)    \
+    PAINT_WRITER(Paint_Put_101_##SUFFIX, 1, 0, 1, PUT)    \
+    PAINT_WRITER(Paint_Put_110_##SUFFIX, 1, 1, 0, PUT)    \
+    PAINT_WRITER(Paint_Put_111_##SUFFIX, 1, 1, 1, PUT)
+
+PAINT_WRITERS(1bpp, PAINT_PUT_1BPP)
+PAINT_WRITERS(2bpp, PAINT_PUT_2BPP)
+PAINT_WRITERS(4bpp, PAINT_PUT_4BPP)
+
+// Indexed by scale (1bpp, 2bpp, 4bpp), then by Paint_Transform()
+static const PAINT_WRITER_FN Paint_Writers[3][8] = {
+    {Paint_Put_000_1bpp, Paint_Put_001_1bpp, Paint_Put_010_1bpp, Paint_Put_011_1bpp,
+     Paint_Put_100_1bpp, Paint_Put_101_1bpp, Paint_Put_110_1bpp, Paint_Put_111_1bpp},
+    {Paint_Put_000_2bpp, Paint_Put_001_2bpp, Paint_Put_010_2bpp, Paint_Put_011_2bpp,
+     Paint_Put_100_2bpp, Paint_Put_101_2bpp, Paint_Put_110_2bpp, Paint_Put_111_2bpp},
+    {Paint_Put_000_4bpp, Paint_Put_001_4bpp, Paint_Put_010_4bpp, Paint_Put_011_4bpp,
+     Paint_Put_100_4bpp, Paint_Put_101_4bpp, Paint_Put_110_4bpp, Paint_Put_111_4bpp},
+};
+
+// Memory transform bits, see Paint_Transform
+#define PAINT_SWAP 0x04
+#define PAINT_FLIP_X 0x02
+#define PAINT_FLIP_Y 0x01
+
+/******************************************************************************
+function: Memory transform for the current rotation and mirror
+parameter:
+info:
+    Returns PAINT_SWAP, PAINT_FLIP_X and PAINT_FLIP_Y bits: drawing X/Y are
+    swapped first, then buffer X and Y are flipped.
+******************************************************************************/
+static UBYTE Paint_Transform(PAINT *P)
+{
+    UBYTE T;
+    switch (P->Rotate)
+    {
+    case ROTATE_90:
+        T = PAINT_SWAP | PAINT_FLIP_X;
+        break;
+    case ROTATE_180:
+        T = PAINT_FLIP_X | PAINT_FLIP_Y;
+        break;
+    case ROTATE_270:
+        T = PAINT_SWAP | PAINT_FLIP_Y;
+        break;
+    default:
+        T = 0;
+        break;
+    }
+    if (P->Mirror & MIRROR_HORIZONTAL)
+        T ^= PAINT_FLIP_X;
+    if (P->Mirror & MIRROR_VERTICAL)
+        T ^= PAINT_FLIP_Y;
+    return T;
+}
+
+/******************************************************************************
+function: Pick the pixel writer for the current rotation, mirror and scale
+parameter:
+******************************************************************************/
+static void Paint_UpdateWriter(PAINT *P)
+{
+    UBYTE Depth = (P->Scale == 4) ? 1 : (P->Scale == 7) ? 2 : 0;
+    P->Writer = Paint_Writers[Depth][Paint_Transform(P)];
+}
+
 /******************************************************************************
 function: Create Image
 parameter:
@@ -33,33 +158,41 @@ parameter:
     Height  :   The height of the picture
     Color   :   Whether the picture is inverted
 ******************************************************************************/
-void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
+void Paint_NewImage_Ctx(PAINT *P, UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
 {
-    Paint.Image = NULL;
-    Paint.Image = image;
+    P->Image = NULL;
+    P->Image = image;
+    P->ImageRow = 0;
 
-    Paint.WidthMemory = Width;
-    Paint.HeightMemory = Height;
-    Paint.Color = Color;
-    Paint.Scale = 2;
-    Paint.WidthByte = (Width % 8 == 0) ? (Width / 8) : (Width / 8 + 1);
-    Paint.HeightByte = Height;
-    //    printf("WidthByte = %d, HeightByte = %d\r\n", Paint.WidthByte, Paint.HeightByte);
+    P->WidthMemory = Width;
+    P->HeightMemory = Height;
+    P->Color = Color;
+    P->Scale = 2;
+    P->WidthByte = (Width % 8 == 0) ? (Width / 8) : (Width / 8 + 1);
+    P->HeightByte = Height;
+    //    printf("WidthByte = %d, HeightByte = %d\r\n", P->WidthByte, P->HeightByte);
     //    printf(" EPD_WIDTH / 8 = %d\r\n",  122 / 8);
 
-    Paint.Rotate = Rotate;
-    Paint.Mirror = MIRROR_NONE;
+    P->Rotate = Rotate;
+    P->Mirror = MIRROR_NONE;
 
     if (Rotate == ROTATE_0 || Rotate == ROTATE_180)
     {
-        Paint.Width = Width;
-        Paint.Height = Height;
+        P->Width = Width;
+        P->Height = Height;
     }
     else
     {
-        Paint.Width = Height;
-        Paint.Height = Width;
+        P->Width = Height;
+        P->Height = Width;
     }
+    Paint_UpdateWriter(P);
+    Paint_ResetClip_Ctx(P);
+}
+
+void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
+{
+    Paint_NewImage_Ctx(&Paint, image, Width, Height, Rotate, Color);
 }
 
 /******************************************************************************
@@ -67,9 +200,63 @@ function: Select Image
 parameter:
     image : Pointer to the image cache
 ******************************************************************************/
+void Paint_SelectImage_Ctx(PAINT *P, UBYTE *image)
+{
+    P->Image = image;
+    P->ImageRow = 0;
+}
+
 void Paint_SelectImage(UBYTE *image)
 {
-    Paint.Image = image;
+    Paint_SelectImage_Ctx(&Paint, image);
+}
+
+/******************************************************************************
+function: Select a band buffer holding some memory rows of the image
+parameter:
+    Band   : Rows * WidthByte bytes, image memory row Ystart first
+    Ystart : First memory row in the band
+    Rows   : Number of memory rows in the band
+info:
+    Drawing is clipped to the part of the image stored in the band, so the
+    rows around it are never touched. Clears the clip stack. Paint_Clear
+    fills the whole image and must not be used on a band, use
+    Paint_ClearWindows_S instead.
+******************************************************************************/
+void Paint_SelectBand_Ctx(PAINT *P, UBYTE *Band, UWORD Ystart, UWORD Rows)
+{
+    UBYTE T = Paint_Transform(P);
+    UWORD Lo = (Ystart < P->HeightMemory) ? Ystart : P->HeightMemory;
+    UWORD Hi = (Rows < P->HeightMemory - Lo) ? Lo + Rows : P->HeightMemory;
+
+    // Memory rows back to drawing coordinates
+    if (T & PAINT_FLIP_Y)
+    {
+        UWORD Top = P->HeightMemory - Hi;
+        Hi = P->HeightMemory - Lo;
+        Lo = Top;
+    }
+    P->ClipDepth = 0;
+    Paint_ResetClip_Ctx(P);
+    if (T & PAINT_SWAP)
+    {
+        P->Clip.Xstart = Lo;
+        P->Clip.Xend = Hi;
+    }
+    else
+    {
+        P->Clip.Ystart = Lo;
+        P->Clip.Yend = Hi;
+    }
+
+    // Writers address row Y at Band[(Y - Ystart) * WidthByte]
+    P->Image = Band;
+    P->ImageRow = Ystart;
+}
+
+void Paint_SelectBand(UBYTE *Band, UWORD Ystart, UWORD Rows)
+{
+    Paint_SelectBand_Ctx(&Paint, Band, Ystart, Rows);
 }
 
 /******************************************************************************
@@ -77,12 +264,25 @@ function: Select Image Rotate
 parameter:
     Rotate : 0,90,180,270
 ******************************************************************************/
-void Paint_SetRotate(UWORD Rotate)
+void Paint_SetRotate_Ctx(PAINT *P, UWORD Rotate)
 {
     if (Rotate == ROTATE_0 || Rotate == ROTATE_90 || Rotate == ROTATE_180 || Rotate == ROTATE_270)
     {
         Debug("Set image Rotate %d\r\n", Rotate);
-        Paint.Rotate = Rotate;
+        P->Rotate = Rotate;
+        // Keep the drawing area in step with the rotation, as Paint_NewImage does
+        if (Rotate == ROTATE_0 || Rotate == ROTATE_180)
+        {
+            P->Width = P->WidthMemory;
+            P->Height = P->HeightMemory;
+        }
+        else
+        {
+            P->Width = P->HeightMemory;
+            P->Height = P->WidthMemory;
+        }
+        Paint_UpdateWriter(P);
+        Paint_ResetClip_Ctx(P);
     }
     else
     {
@@ -90,18 +290,24 @@ void Paint_SetRotate(UWORD Rotate)
     }
 }
 
+void Paint_SetRotate(UWORD Rotate)
+{
+    Paint_SetRotate_Ctx(&Paint, Rotate);
+}
+
 /******************************************************************************
 function:	Select Image mirror
 parameter:
     mirror   :Not mirror,Horizontal mirror,Vertical mirror,Origin mirror
 ******************************************************************************/
-void Paint_SetMirroring(UBYTE mirror)
+void Paint_SetMirroring_Ctx(PAINT *P, UBYTE mirror)
 {
     if (mirror == MIRROR_NONE || mirror == MIRROR_HORIZONTAL ||
         mirror == MIRROR_VERTICAL || mirror == MIRROR_ORIGIN)
     {
         Debug("mirror image x:%s, y:%s\r\n", (mirror & 0x01) ? "mirror" : "none", ((mirror >> 1) & 0x01) ? "mirror" : "none");
-        Paint.Mirror = mirror;
+        P->Mirror = mirror;
+        Paint_UpdateWriter(P);
     }
     else
     {
@@ -109,149 +315,343 @@ void Paint_SetMirroring(UBYTE mirror)
     }
 }
 
-void Paint_SetScale(UBYTE scale)
+void Paint_SetMirroring(UBYTE mirror)
+{
+    Paint_SetMirroring_Ctx(&Paint, mirror);
+}
+
+void Paint_SetScale_Ctx(PAINT *P, UBYTE scale)
 {
     if (scale == 2)
     {
-        Paint.Scale = scale;
-        Paint.WidthByte = (Paint.WidthMemory % 8 == 0) ? (Paint.WidthMemory / 8) : (Paint.WidthMemory / 8 + 1);
+        P->Scale = scale;
+        P->WidthByte = (P->WidthMemory % 8 == 0) ? (P->WidthMemory / 8) : (P->WidthMemory / 8 + 1);
     }
     else if (scale == 4)
     {
-        Paint.Scale = scale;
-        Paint.WidthByte = (Paint.WidthMemory % 4 == 0) ? (Paint.WidthMemory / 4) : (Paint.WidthMemory / 4 + 1);
+        P->Scale = scale;
+        P->WidthByte = (P->WidthMemory % 4 == 0) ? (P->WidthMemory / 4) : (P->WidthMemory / 4 + 1);
     }
     else if (scale == 7)
     { // Only applicable with 5in65 e-Paper
-        Paint.Scale = scale;
-        Paint.WidthByte = (Paint.WidthMemory % 2 == 0) ? (Paint.WidthMemory / 2) : (Paint.WidthMemory / 2 + 1);
+        P->Scale = scale;
+        P->WidthByte = (P->WidthMemory % 2 == 0) ? (P->WidthMemory / 2) : (P->WidthMemory / 2 + 1);
         ;
     }
     else
     {
         ESP_LOGW(TAG, "Invalid scale value %d (only 2, 4, and 7 are supported)", scale);
+        return;
+    }
+    Paint_UpdateWriter(P);
+}
+
+void Paint_SetScale(UBYTE scale)
+{
+    Paint_SetScale_Ctx(&Paint, scale);
+}
+/******************************************************************************
+function: Limit drawing to a rectangle
+parameter:
+    Xstart, Ystart : Top-left corner
+    Xend, Yend     : Bottom-right corner, exclusive
+info:
+    The new clip is the intersection with the current one, so nested clips
+    only ever shrink. Returns 1 when PAINT_CLIP_DEPTH clips are already
+    pushed. Paint_NewImage and Paint_SetRotate drop all clips.
+******************************************************************************/
+UBYTE Paint_PushClip_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend)
+{
+    if (P->ClipDepth >= PAINT_CLIP_DEPTH)
+    {
+        ESP_LOGE(TAG, "Clip stack full (%d)", PAINT_CLIP_DEPTH);
+        return 1;
+    }
+    P->ClipStack[P->ClipDepth++] = P->Clip;
+
+    // Clamp every edge into the current clip, an empty result keeps Xend >= Xstart
+    Xstart = (Xstart < P->Clip.Xstart) ? P->Clip.Xstart : (Xstart > P->Clip.Xend) ? P->Clip.Xend : Xstart;
+    Ystart = (Ystart < P->Clip.Ystart) ? P->Clip.Ystart : (Ystart > P->Clip.Yend) ? P->Clip.Yend : Ystart;
+    Xend = (Xend < Xstart) ? Xstart : (Xend > P->Clip.Xend) ? P->Clip.Xend : Xend;
+    Yend = (Yend < Ystart) ? Ystart : (Yend > P->Clip.Yend) ? P->Clip.Yend : Yend;
+
+    P->Clip.Xstart = Xstart;
+    P->Clip.Ystart = Ystart;
+    P->Clip.Xend = Xend;
+    P->Clip.Yend = Yend;
+    return 0;
+}
+
+UBYTE Paint_PushClip(int Xstart, int Ystart, int Xend, int Yend)
+{
+    return Paint_PushClip_Ctx(&Paint, Xstart, Ystart, Xend, Yend);
+}
+
+/******************************************************************************
+function: Restore the clip rectangle in use before the last Paint_PushClip
+parameter:
+info:
+    Returns 1 when no clip is pushed.
+******************************************************************************/
+UBYTE Paint_PopClip_Ctx(PAINT *P)
+{
+    if (P->ClipDepth == 0)
+    {
+        ESP_LOGE(TAG, "Clip stack empty");
+        return 1;
+    }
+    P->Clip = P->ClipStack[--P->ClipDepth];
+    return 0;
+}
+
+UBYTE Paint_PopClip(void)
+{
+    return Paint_PopClip_Ctx(&Paint);
+}
+
+/******************************************************************************
+function: Drop all clips, drawing covers the whole image again
+parameter:
+******************************************************************************/
+void Paint_ResetClip_Ctx(PAINT *P)
+{
+    P->Clip.Xstart = 0;
+    P->Clip.Ystart = 0;
+    P->Clip.Xend = P->Width;
+    P->Clip.Yend = P->Height;
+    P->ClipDepth = 0;
+}
+
+void Paint_ResetClip(void)
+{
+    Paint_ResetClip_Ctx(&Paint);
+}
+
+/******************************************************************************
+function: Intersect a rectangle with the clip rectangle
+parameter:
+    Xstart, Ystart : Top-left corner, inclusive, updated
+    Xend, Yend     : Bottom-right corner, inclusive, updated
+info:
+    Returns 0 when nothing of the rectangle is visible.
+******************************************************************************/
+static UBYTE Paint_ClipRect(PAINT *P, int *Xstart, int *Ystart, int *Xend, int *Yend)
+{
+    if (*Xstart < P->Clip.Xstart)
+        *Xstart = P->Clip.Xstart;
+    if (*Ystart < P->Clip.Ystart)
+        *Ystart = P->Clip.Ystart;
+    if (*Xend > P->Clip.Xend - 1)
+        *Xend = P->Clip.Xend - 1;
+    if (*Yend > P->Clip.Yend - 1)
+        *Yend = P->Clip.Yend - 1;
+    return *Xstart <= *Xend && *Ystart <= *Yend;
+}
+
+/******************************************************************************
+function: Map a rectangle in drawing coordinates into the image buffer
+parameter:
+    Xstart, Ystart : Top-left corner, inclusive, inside the image
+    Xend, Yend     : Bottom-right corner, inclusive, inside the image
+    X0, Y0, X1, Y1 : Filled with the same rectangle in memory coordinates
+info:
+    Rotation and mirror map each axis linearly, so the result is again a
+    rectangle.
+******************************************************************************/
+static void Paint_MapRect(PAINT *P, int Xstart, int Ystart, int Xend, int Yend,
+                                    UWORD *X0, UWORD *Y0, UWORD *X1, UWORD *Y1)
+{
+    UBYTE T = Paint_Transform(P);
+    int Tmp;
+    if (T & PAINT_SWAP)
+    {
+        Tmp = Xstart, Xstart = Ystart, Ystart = Tmp;
+        Tmp = Xend, Xend = Yend, Yend = Tmp;
+    }
+    if (T & PAINT_FLIP_X)
+    {
+        Tmp = Xstart;
+        Xstart = P->WidthMemory - Xend - 1;
+        Xend = P->WidthMemory - Tmp - 1;
+    }
+    if (T & PAINT_FLIP_Y)
+    {
+        Tmp = Ystart;
+        Ystart = P->HeightMemory - Yend - 1;
+        Yend = P->HeightMemory - Tmp - 1;
     }
+    *X0 = Xstart, *Y0 = Ystart, *X1 = Xend, *Y1 = Yend;
 }
+
 /******************************************************************************
 function: Draw Pixels
 parameter:
     Xpoint : At point X
     Ypoint : At point Y
     Color  : Painted colors
+info:
+    Pixels outside the clip rectangle are skipped without a warning.
 ******************************************************************************/
+void Paint_SetPixel_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    P->Writer(P, Xpoint, Ypoint, Color);
+}
+
 void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
 {
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
-    {
-        ESP_LOGW(TAG, "Pixel (%d,%d) exceeds display boundaries (%dx%d)", Xpoint, Ypoint, Paint.Width, Paint.Height);
+    Paint_SetPixel_Ctx(&Paint, Xpoint, Ypoint, Color);
+}
+
+/******************************************************************************
+function: Draw Pixels at signed coordinates
+parameter:
+    Xpoint : At point X
+    Ypoint : At point Y
+    Color  : Painted colors
+******************************************************************************/
+void Paint_SetPixel_S_Ctx(PAINT *P, int Xpoint, int Ypoint, UWORD Color)
+{
+    if (Xpoint < P->Clip.Xstart || Xpoint >= P->Clip.Xend ||
+        Ypoint < P->Clip.Ystart || Ypoint >= P->Clip.Yend)
         return;
+    P->Writer(P, Xpoint, Ypoint, Color);
+}
+
+void Paint_SetPixel_S(int Xpoint, int Ypoint, UWORD Color)
+{
+    Paint_SetPixel_S_Ctx(&Paint, Xpoint, Ypoint, Color);
+}
+
+/******************************************************************************
+function: Fill a rectangle given in memory coordinates
+parameter:
+    X0, Y0 : Top-left corner in the image buffer, inclusive
+    X1, Y1 : Bottom-right corner in the image buffer, inclusive
+    Color  : Painted colors
+info:
+    Each row is filled with edge masks for the partial bytes and memset
+    for the whole bytes in between.
+******************************************************************************/
+static void Paint_FillMemRect(PAINT *P, UWORD X0, UWORD Y0, UWORD X1, UWORD Y1, UWORD Color)
+{
+    UBYTE Bpp, Pattern;
+    if (P->Scale == 2)
+    {
+        Bpp = 1;
+        Pattern = (Color == BLACK) ? 0x00 : 0xFF;
     }
-    UWORD X, Y;
-    switch (Paint.Rotate)
+    else if (P->Scale == 4)
     {
-    case 0:
-        X = Xpoint;
-        Y = Ypoint;
-        break;
-    case 90:
-        X = Paint.WidthMemory - Ypoint - 1;
-        Y = Xpoint;
-        break;
-    case 180:
-        X = Paint.WidthMemory - Xpoint - 1;
-        Y = Paint.HeightMemory - Ypoint - 1;
-        break;
-    case 270:
-        X = Ypoint;
-        Y = Paint.HeightMemory - Xpoint - 1;
-        break;
-    default:
-        return;
+        Bpp = 2;
+        Pattern = (Color % 4) * 0x55;
     }
-
-    switch (Paint.Mirror)
+    else if (P->Scale == 7)
     {
-    case MIRROR_NONE:
-        break;
-    case MIRROR_HORIZONTAL:
-        X = Paint.WidthMemory - X - 1;
-        break;
-    case MIRROR_VERTICAL:
-        Y = Paint.HeightMemory - Y - 1;
-        break;
-    case MIRROR_ORIGIN:
-        X = Paint.WidthMemory - X - 1;
-        Y = Paint.HeightMemory - Y - 1;
-        break;
-    default:
-        return;
+        Bpp = 4;
+        Pattern = ((Color & 0x0F) << 4) | (Color & 0x0F);
     }
-
-    if (X > Paint.WidthMemory || Y > Paint.HeightMemory)
+    else
     {
-        ESP_LOGW(TAG, "Pixel (%d,%d) exceeds display boundaries (%dx%d)", Xpoint, Ypoint, Paint.Width, Paint.Height);
         return;
     }
 
-    if (Paint.Scale == 2)
+    UDOUBLE BitStart = (UDOUBLE)X0 * Bpp;
+    UDOUBLE BitEnd = (UDOUBLE)(X1 + 1) * Bpp - 1;
+    UWORD First = BitStart / 8, Last = BitEnd / 8;
+    UBYTE HeadMask = 0xFF >> (BitStart % 8);
+    UBYTE TailMask = 0xFF << (7 - BitEnd % 8);
+    if (First == Last)
     {
-        UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
-        UBYTE Rdata = Paint.Image[Addr];
-        if (Color == BLACK)
-            Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
-        else
-            Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
+        HeadMask &= TailMask;
     }
-    else if (Paint.Scale == 4)
+
+    for (UWORD Y = Y0; Y <= Y1; Y++)
     {
-        UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
-        Color = Color % 4; // Guaranteed color scale is 4  --- 0~3
-        UBYTE Rdata = Paint.Image[Addr];
+        UBYTE *Row = PAINT_ROW(P, Y);
+        Row[First] = (Row[First] & ~HeadMask) | (Pattern & HeadMask);
+        if (First != Last)
+        {
+            memset(&Row[First + 1], Pattern, Last - First - 1);
+            Row[Last] = (Row[Last] & ~TailMask) | (Pattern & TailMask);
+        }
+    }
+}
+
+/******************************************************************************
+function: Copy a rectangle given in memory coordinates from another buffer
+parameter:
+    Src    : Buffer with the layout of the image
+    X0, Y0 : Top-left corner in the image buffer, inclusive
+    X1, Y1 : Bottom-right corner in the image buffer, inclusive
+******************************************************************************/
+static void Paint_CopyMemRect(PAINT *P, const UBYTE *Src, UWORD X0, UWORD Y0, UWORD X1, UWORD Y1)
+{
+    UBYTE Bpp = (P->Scale == 2) ? 1 : (P->Scale == 4) ? 2 : (P->Scale == 7) ? 4 : 0;
+    if (Bpp == 0)
+        return;
 
-        Rdata = Rdata & (~(0xC0 >> ((X % 4) * 2))); // Clear first, then set value
-        Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4) * 2));
+    UDOUBLE BitStart = (UDOUBLE)X0 * Bpp;
+    UDOUBLE BitEnd = (UDOUBLE)(X1 + 1) * Bpp - 1;
+    UWORD First = BitStart / 8, Last = BitEnd / 8;
+    UBYTE HeadMask = 0xFF >> (BitStart % 8);
+    UBYTE TailMask = 0xFF << (7 - BitEnd % 8);
+    if (First == Last)
+    {
+        HeadMask &= TailMask;
     }
-    else if (Paint.Scale == 7)
+
+    for (UWORD Y = Y0; Y <= Y1; Y++)
     {
-        UDOUBLE Addr = X / 2 + Y * Paint.WidthByte;
-        UBYTE Rdata = Paint.Image[Addr];
-        Rdata = Rdata & (~(0xF0 >> ((X % 2) * 4))); // Clear first, then set value
-        Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2) * 4));
-        // printf("Add =  %d ,data = %d\r\n",Addr,Rdata);
+        UBYTE *Row = PAINT_ROW(P, Y);
+        const UBYTE *In = &Src[(UDOUBLE)Y * P->WidthByte];
+        Row[First] = (Row[First] & ~HeadMask) | (In[First] & HeadMask);
+        if (First != Last)
+        {
+            memcpy(&Row[First + 1], &In[First + 1], Last - First - 1);
+            Row[Last] = (Row[Last] & ~TailMask) | (In[Last] & TailMask);
+        }
     }
 }
 
+/******************************************************************************
+function: Fill a rectangle given in drawing coordinates
+parameter:
+    Xstart, Ystart : Top-left corner, inclusive, may lie outside the clip
+    Xend, Yend     : Bottom-right corner, inclusive, may lie outside the clip
+    Color          : Painted colors
+******************************************************************************/
+static void Paint_FillRectClipped(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, UWORD Color)
+{
+    UWORD X0, Y0, X1, Y1;
+    if (!Paint_ClipRect(P, &Xstart, &Ystart, &Xend, &Yend))
+        return;
+    Paint_MapRect(P, Xstart, Ystart, Xend, Yend, &X0, &Y0, &X1, &Y1);
+    Paint_FillMemRect(P, X0, Y0, X1, Y1, Color);
+}
+
 /******************************************************************************
 function: Clear the color of the picture
 parameter:
     Color : Painted colors
 ******************************************************************************/
-void Paint_Clear(UWORD Color)
+void Paint_Clear_Ctx(PAINT *P, UWORD Color)
 {
-    if (Paint.Scale == 2 || Paint.Scale == 4)
+    UDOUBLE Bytes = (UDOUBLE)P->WidthByte * P->HeightByte;
+    if (P->Scale == 2 || P->Scale == 4)
     {
-        for (UWORD Y = 0; Y < Paint.HeightByte; Y++)
-        {
-            for (UWORD X = 0; X < Paint.WidthByte; X++)
-            { // 8 pixel =  1 byte
-                UDOUBLE Addr = X + Y * Paint.WidthByte;
-                Paint.Image[Addr] = Color;
-            }
-        }
+        Frame_Fill(P->Image, (UBYTE)Color, Bytes);
     }
-    else if (Paint.Scale == 7)
+    else if (P->Scale == 7)
     {
-        for (UWORD Y = 0; Y < Paint.HeightByte; Y++)
-        {
-            for (UWORD X = 0; X < Paint.WidthByte; X++)
-            {
-                UDOUBLE Addr = X + Y * Paint.WidthByte;
-                Paint.Image[Addr] = (Color << 4) | Color;
-            }
-        }
+        Frame_Fill(P->Image, (UBYTE)((Color << 4) | Color), Bytes);
     }
 }
 
+void Paint_Clear(UWORD Color)
+{
+    Paint_Clear_Ctx(&Paint, Color);
+}
+
 /******************************************************************************
 function: Clear the color of a window
 parameter:
@@ -261,16 +661,33 @@ parameter:
     Yend   : y end point
     Color  : Painted colors
 ******************************************************************************/
+void Paint_ClearWindows_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    Paint_ClearWindows_S_Ctx(P, Xstart, Ystart, Xend, Yend, Color);
+}
+
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
 {
-    UWORD X, Y;
-    for (Y = Ystart; Y < Yend; Y++)
-    {
-        for (X = Xstart; X < Xend; X++)
-        { // 8 pixel =  1 byte
-            Paint_SetPixel(X, Y, Color);
-        }
-    }
+    Paint_ClearWindows_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color);
+}
+
+/******************************************************************************
+function: Clear the color of a window at signed coordinates
+parameter:
+    Xstart : x starting point
+    Ystart : Y starting point
+    Xend   : x end point, exclusive
+    Yend   : y end point, exclusive
+    Color  : Painted colors
+******************************************************************************/
+void Paint_ClearWindows_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, UWORD Color)
+{
+    Paint_FillRectClipped(P, Xstart, Ystart, Xend - 1, Yend - 1, Color);
+}
+
+void Paint_ClearWindows_S(int Xstart, int Ystart, int Xend, int Yend, UWORD Color)
+{
+    Paint_ClearWindows_S_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color);
 }
 
 /******************************************************************************
@@ -282,220 +699,1517 @@ parameter:
     Dot_Pixel	: point size
     Dot_Style	: point Style
 ******************************************************************************/
-void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
-                     DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+void Paint_DrawPoint_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, UWORD Color,
+                                   DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
 {
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
+    if (Xpoint > P->Width || Ypoint > P->Height)
     {
         ESP_LOGW(TAG, "DrawPoint at (%d,%d) exceeds display range", Xpoint, Ypoint);
         return;
     }
+    Paint_DrawPoint_S_Ctx(P, Xpoint, Ypoint, Color, Dot_Pixel, Dot_Style);
+}
 
-    int16_t XDir_Num, YDir_Num;
-    if (Dot_Style == DOT_FILL_AROUND)
-    {
-        for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++)
-        {
-            for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++)
-            {
-                if (Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
-                    break;
-                // printf("x = %d, y = %d\r\n", Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel);
-                Paint_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
-            }
-        }
-    }
-    else
-    {
-        for (XDir_Num = 0; XDir_Num < Dot_Pixel; XDir_Num++)
-        {
-            for (YDir_Num = 0; YDir_Num < Dot_Pixel; YDir_Num++)
-            {
-                Paint_SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
-            }
-        }
-    }
+void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
+                     DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    Paint_DrawPoint_Ctx(&Paint, Xpoint, Ypoint, Color, Dot_Pixel, Dot_Style);
 }
 
 /******************************************************************************
-function: Draw a line of arbitrary slope
+function: Draw Point(Xpoint, Ypoint) at signed coordinates
 parameter:
-    Xstart ：Starting Xpoint point coordinates
-    Ystart ：Starting Xpoint point coordinates
-    Xend   ：End point Xpoint coordinate
-    Yend   ：End point Ypoint coordinate
-    Color  ：The color of the line segment
+    Xpoint		: The Xpoint coordinate of the point
+    Ypoint		: The Ypoint coordinate of the point
+    Color		: Painted color
+    Dot_Pixel	: point size
+    Dot_Style	: point Style
+info:
+    DOT_FILL_AROUND covers Xpoint - Dot_Pixel to Xpoint + Dot_Pixel - 2,
+    DOT_FILL_RIGHTUP covers Xpoint - 1 to Xpoint + Dot_Pixel - 2, the same
+    on Y.
+******************************************************************************/
+void Paint_DrawPoint_S_Ctx(PAINT *P, int Xpoint, int Ypoint, UWORD Color,
+                                     DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    int Xstart = Xpoint - 1, Ystart = Ypoint - 1;
+    if (Dot_Style == DOT_FILL_AROUND)
+    {
+        Xstart = Xpoint - Dot_Pixel;
+        Ystart = Ypoint - Dot_Pixel;
+    }
+
+    if (Dot_Pixel == DOT_PIXEL_1X1)
+        Paint_SetPixel_S_Ctx(P, Xstart, Ystart, Color);
+    else
+        Paint_FillRectClipped(P, Xstart, Ystart, Xpoint + Dot_Pixel - 2, Ypoint + Dot_Pixel - 2, Color);
+}
+
+void Paint_DrawPoint_S(int Xpoint, int Ypoint, UWORD Color,
+                       DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    Paint_DrawPoint_S_Ctx(&Paint, Xpoint, Ypoint, Color, Dot_Pixel, Dot_Style);
+}
+
+/******************************************************************************
+function: Floor of A / B for B > 0
+parameter:
+******************************************************************************/
+static int64_t Paint_DivFloor(int64_t A, int64_t B)
+{
+    return (A >= 0) ? A / B : -((-A + B - 1) / B);
+}
+
+/******************************************************************************
+function: Narrow an interval of t to where Lo <= K * t + C <= Hi
+parameter:
+    K, C     : Linear function of t
+    Lo, Hi   : Allowed range of the function
+    Tlo, Thi : Interval of t, updated
+******************************************************************************/
+static void Paint_Slab(float K, float C, float Lo, float Hi, float *Tlo, float *Thi)
+{
+    if (K > -1e-6f && K < 1e-6f)
+    {
+        if (C < Lo || C > Hi)
+            *Tlo = 1, *Thi = 0;
+        return;
+    }
+    float T1 = (Lo - C) / K, T2 = (Hi - C) / K;
+    if (T1 > T2)
+    {
+        float T = T1;
+        T1 = T2, T2 = T;
+    }
+    if (T1 > *Tlo)
+        *Tlo = T1;
+    if (T2 < *Thi)
+        *Thi = T2;
+}
+
+/******************************************************************************
+function: Fill a line wider than one pixel
+parameter:
+    Xstart, Ystart : Starting point
+    Xend, Yend     : End point
+    Color          : Painted color
+    Line_width     : Line width, 2 * Line_width - 1 pixels across
+    Line_Cap       : End caps
+info:
+    The line is a rectangle, stretched by the square caps, joined with two
+    discs for round caps. That shape is convex, so each row holds one span:
+    the pixel centers within both slabs of the rectangle, or within a disc.
+    Rows are taken in the image buffer, so every span is a run of bytes in
+    any rotation. Horizontal and vertical lines without round caps are a
+    single rectangle fill. Points are centered offset by (-1, -1), as
+    Paint_DrawPoint does.
+******************************************************************************/
+static void Paint_FillThickLine(PAINT *P, int Xstart, int Ystart, int Xend, int Yend,
+                                          UWORD Color, int Line_width, LINE_CAP Line_Cap)
+{
+    int Ext = (Line_Cap == LINE_CAP_SQUARE) ? Line_width - 1 : 0;
+    int Half = Line_width - 1;
+    int Xmin = (Xstart < Xend) ? Xstart : Xend, Xmax = (Xstart < Xend) ? Xend : Xstart;
+    int Ymin = (Ystart < Yend) ? Ystart : Yend, Ymax = (Ystart < Yend) ? Yend : Ystart;
+
+    if (Line_Cap != LINE_CAP_ROUND && (Ystart == Yend || Xstart == Xend))
+    {
+        if (Ystart == Yend)
+            Paint_FillRectClipped(P, Xmin - 1 - Ext, Ystart - 1 - Half, Xmax - 1 + Ext, Ystart - 1 + Half, Color);
+        else
+            Paint_FillRectClipped(P, Xstart - 1 - Half, Ymin - 1 - Ext, Xstart - 1 + Half, Ymax - 1 + Ext, Color);
+        return;
+    }
+
+    // Work in memory coordinates, rotation and mirror keep the shape, and
+    // each span is then one run of bytes
+    int Cx0 = P->Clip.Xstart, Cy0 = P->Clip.Ystart;
+    int Cx1 = P->Clip.Xend - 1, Cy1 = P->Clip.Yend - 1;
+    if (Cx0 > Cx1 || Cy0 > Cy1)
+        return;
+    if (Xmax - 1 + Line_width * 2 < Cx0 || Xmin - 1 - Line_width * 2 > Cx1 ||
+        Ymax - 1 + Line_width * 2 < Cy0 || Ymin - 1 - Line_width * 2 > Cy1)
+        return;
+    UWORD MX0, MY0, MX1, MY1;
+    Paint_MapRect(P, Cx0, Cy0, Cx1, Cy1, &MX0, &MY0, &MX1, &MY1);
+
+    UBYTE T = Paint_Transform(P);
+    float X0 = Xstart - 1, Y0 = Ystart - 1, X1 = Xend - 1, Y1 = Yend - 1, Tmp;
+    if (T & PAINT_SWAP)
+    {
+        Tmp = X0, X0 = Y0, Y0 = Tmp;
+        Tmp = X1, X1 = Y1, Y1 = Tmp;
+    }
+    if (T & PAINT_FLIP_X)
+    {
+        X0 = P->WidthMemory - 1 - X0;
+        X1 = P->WidthMemory - 1 - X1;
+    }
+    if (T & PAINT_FLIP_Y)
+    {
+        Y0 = P->HeightMemory - 1 - Y0;
+        Y1 = P->HeightMemory - 1 - Y1;
+    }
+
+    float H = Line_width - 0.5f;
+    float Dx = X1 - X0, Dy = Y1 - Y0;
+    float Len = sqrtf(Dx * Dx + Dy * Dy);
+    float Ux = (Len > 0) ? Dx / Len : 1, Uy = (Len > 0) ? Dy / Len : 0;
+    float A = (Line_Cap == LINE_CAP_SQUARE) ? -H : 0, B = Len - A;
+
+    // Corners of a square cap reach H * sqrt(2) from the end points
+    float Reach = H * 1.5f + 1;
+    int Row0 = (int)floorf(((Y0 < Y1) ? Y0 : Y1) - Reach), Row1 = (int)ceilf(((Y0 < Y1) ? Y1 : Y0) + Reach);
+    if (Row0 < MY0)
+        Row0 = MY0;
+    if (Row1 > MY1)
+        Row1 = MY1;
+
+    for (int Y = Row0; Y <= Row1; Y++)
+    {
+        // t = X - X0 along this row: along the line in [A, B], across in [-H, H]
+        float Ry = Y - Y0;
+        float Tlo = -1e30f, Thi = 1e30f;
+        Paint_Slab(Ux, Ry * Uy, A, B, &Tlo, &Thi);
+        Paint_Slab(-Uy, Ry * Ux, -H, H, &Tlo, &Thi);
+
+        if (Line_Cap == LINE_CAP_ROUND)
+        {
+            for (int End = 0; End < 2; End++)
+            {
+                float Ex = End ? Dx : 0, Ey = End ? Y1 : Y0;
+                float D = Y - Ey;
+                if (D * D <= H * H)
+                {
+                    float W = sqrtf(H * H - D * D);
+                    if (Tlo > Thi)
+                        Tlo = Ex - W, Thi = Ex + W;
+                    if (Ex - W < Tlo)
+                        Tlo = Ex - W;
+                    if (Ex + W > Thi)
+                        Thi = Ex + W;
+                }
+            }
+        }
+        if (Tlo > Thi)
+            continue;
+
+        int Xl = (int)ceilf(X0 + Tlo - 1e-3f), Xr = (int)floorf(X0 + Thi + 1e-3f);
+        if (Xl < MX0)
+            Xl = MX0;
+        if (Xr > MX1)
+            Xr = MX1;
+        if (Xl <= Xr)
+            Paint_FillMemRect(P, Xl, Y, Xr, Y, Color);
+    }
+}
+
+/******************************************************************************
+function: Draw a line of arbitrary slope
+parameter:
+    Xstart ：Starting Xpoint point coordinates
+    Ystart ：Starting Xpoint point coordinates
+    Xend   ：End point Xpoint coordinate
+    Yend   ：End point Ypoint coordinate
+    Color  ：The color of the line segment
     Line_width : Line width
     Line_Style: Solid and dotted lines
 ******************************************************************************/
+void Paint_DrawLine_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                                  UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    if (Xstart > P->Width || Ystart > P->Height ||
+        Xend > P->Width || Yend > P->Height)
+    {
+        ESP_LOGW(TAG, "DrawLine (%d,%d)->(%d,%d) exceeds display range", Xstart, Ystart, Xend, Yend);
+        return;
+    }
+    Paint_DrawLine_S_Ctx(P, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Style);
+}
+
 void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
                     UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height)
+    Paint_DrawLine_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Style);
+}
+
+/******************************************************************************
+function: Draw a line of arbitrary slope at signed coordinates
+parameter:
+    Xstart ：Starting Xpoint point coordinates
+    Ystart ：Starting Xpoint point coordinates
+    Xend   ：End point Xpoint coordinate
+    Yend   ：End point Ypoint coordinate
+    Color  ：The color of the line segment
+    Line_width : Line width
+    Line_Style: Solid and dotted lines
+info:
+    Solid lines wider than one pixel are filled one span per row with
+    square caps. Otherwise Bresenham steps once per pixel along the major
+    axis, and at step i the minor axis has moved
+    (2 * Minor * i + Major) / (2 * Major). That lets the walk start at the
+    first step whose point reaches the clip rectangle and stop after the
+    last one, so off-screen parts are never visited.
+******************************************************************************/
+void Paint_DrawLine_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend,
+                                    UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    if (Line_width > DOT_PIXEL_1X1 && Line_Style == LINE_STYLE_SOLID)
     {
-        ESP_LOGW(TAG, "DrawLine (%d,%d)->(%d,%d) exceeds display range", Xstart, Ystart, Xend, Yend);
+        Paint_FillThickLine(P, Xstart, Ystart, Xend, Yend, Color, Line_width, LINE_CAP_SQUARE);
         return;
     }
 
-    UWORD Xpoint = Xstart;
-    UWORD Ypoint = Ystart;
-    int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
-    int dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+    int dx = (Xend >= Xstart) ? Xend - Xstart : Xstart - Xend;
+    int dy = (Yend >= Ystart) ? Yend - Ystart : Ystart - Yend;
 
     // Increment direction, 1 is positive, -1 is counter;
     int XAddway = Xstart < Xend ? 1 : -1;
     int YAddway = Ystart < Yend ? 1 : -1;
 
-    // Cumulative error
-    int Esp = dx + dy;
-    char Dotted_Len = 0;
+    // A point stamps Line_width - 1 pixels before it to Line_width - 2 after
+    // it, so only points in this box can touch the clip rectangle
+    int Xmin = P->Clip.Xstart - Line_width + 2, Xmax = P->Clip.Xend + Line_width - 1;
+    int Ymin = P->Clip.Ystart - Line_width + 2, Ymax = P->Clip.Yend + Line_width - 1;
+
+    UBYTE XMajor = dx >= dy;
+    int Major = XMajor ? dx : dy, Minor = XMajor ? dy : dx;
+    int MajStart = XMajor ? Xstart : Ystart, MinStart = XMajor ? Ystart : Xstart;
+    int MajAdd = XMajor ? XAddway : YAddway, MinAdd = XMajor ? YAddway : XAddway;
+    int MajLo = XMajor ? Xmin : Ymin, MajHi = XMajor ? Xmax : Ymax;
+    int MinLo = XMajor ? Ymin : Xmin, MinHi = XMajor ? Ymax : Xmax;
+
+    // Steps inside the box along the major axis
+    int64_t First = (MajAdd > 0) ? MajLo - MajStart : MajStart - MajHi;
+    int64_t Last = (MajAdd > 0) ? MajHi - MajStart : MajStart - MajLo;
+
+    // Steps inside the box along the minor axis, the minor offset grows with i
+    int64_t JLo = (MinAdd > 0) ? MinLo - MinStart : MinStart - MinHi;
+    int64_t JHi = (MinAdd > 0) ? MinHi - MinStart : MinStart - MinLo;
+    if (Minor == 0)
+    {
+        if (JLo > 0 || JHi < 0)
+            return;
+    }
+    else
+    {
+        int64_t Lo = -Paint_DivFloor(Major - 2 * Major * JLo, 2 * (int64_t)Minor);
+        int64_t Hi = Paint_DivFloor(2 * Major * (JHi + 1) - Major - 1, 2 * (int64_t)Minor);
+        if (Lo > First)
+            First = Lo;
+        if (Hi < Last)
+            Last = Hi;
+    }
+    if (First < 0)
+        First = 0;
+    if (Last > Major)
+        Last = Major;
+    if (First > Last)
+        return;
+
+    // Minor offset J at step First, Rem is the remainder of the division
+    int64_t Den = Major ? 2 * (int64_t)Major : 1;
+    int64_t Num = 2 * (int64_t)Minor * First + Major;
+    int64_t J = Num / Den, Rem = Num % Den;
+
+    for (int64_t i = First; i <= Last; i++)
+    {
+        int Maj = MajStart + MajAdd * (int)i, Min = MinStart + MinAdd * (int)J;
+        int Xpoint = XMajor ? Maj : Min, Ypoint = XMajor ? Min : Maj;
+
+        // Painted dotted line, 2 point is really virtual
+        if (Line_Style == LINE_STYLE_DOTTED && i % 3 == 2)
+        {
+            Paint_DrawPoint_S_Ctx(P, Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
+        }
+        else
+        {
+            Paint_DrawPoint_S_Ctx(P, Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
+        }
+
+        Rem += 2 * Minor;
+        if (Rem >= Den)
+        {
+            Rem -= Den;
+            J++;
+        }
+    }
+}
+
+void Paint_DrawLine_S(int Xstart, int Ystart, int Xend, int Yend,
+                      UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    Paint_DrawLine_S_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Style);
+}
+
+/******************************************************************************
+function: Draw a solid line with the given end caps
+parameter:
+    Xstart ：Starting Xpoint point coordinates
+    Ystart ：Starting Xpoint point coordinates
+    Xend   ：End point Xpoint coordinate
+    Yend   ：End point Ypoint coordinate
+    Color  ：The color of the line segment
+    Line_width : Line width
+    Line_Cap   : End caps
+******************************************************************************/
+void Paint_DrawLineCap_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                                     UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap)
+{
+    if (Xstart > P->Width || Ystart > P->Height ||
+        Xend > P->Width || Yend > P->Height)
+    {
+        ESP_LOGW(TAG, "DrawLineCap (%d,%d)->(%d,%d) exceeds display range", Xstart, Ystart, Xend, Yend);
+        return;
+    }
+    Paint_DrawLineCap_S_Ctx(P, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Cap);
+}
+
+void Paint_DrawLineCap(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                       UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap)
+{
+    Paint_DrawLineCap_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Cap);
+}
+
+/******************************************************************************
+function: Draw a solid line with the given end caps at signed coordinates
+parameter:
+    Xstart ：Starting Xpoint point coordinates
+    Ystart ：Starting Xpoint point coordinates
+    Xend   ：End point Xpoint coordinate
+    Yend   ：End point Ypoint coordinate
+    Color  ：The color of the line segment
+    Line_width : Line width
+    Line_Cap   : End caps
+info:
+    A one pixel line has no caps and is drawn as by Paint_DrawLine_S.
+******************************************************************************/
+void Paint_DrawLineCap_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend,
+                                       UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap)
+{
+    if (Line_width > DOT_PIXEL_1X1)
+        Paint_FillThickLine(P, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Cap);
+    else
+        Paint_DrawLine_S_Ctx(P, Xstart, Ystart, Xend, Yend, Color, Line_width, LINE_STYLE_SOLID);
+}
+
+void Paint_DrawLineCap_S(int Xstart, int Ystart, int Xend, int Yend,
+                         UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap)
+{
+    Paint_DrawLineCap_S_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Cap);
+}
+
+/******************************************************************************
+function: Draw a rectangle
+parameter:
+    Xstart ：Rectangular  Starting Xpoint point coordinates
+    Ystart ：Rectangular  Starting Xpoint point coordinates
+    Xend   ：Rectangular  End point Xpoint coordinate
+    Yend   ：Rectangular  End point Ypoint coordinate
+    Color  ：The color of the Rectangular segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the rectangle
+******************************************************************************/
+void Paint_DrawRectangle_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Xstart > P->Width || Ystart > P->Height ||
+        Xend > P->Width || Yend > P->Height)
+    {
+        ESP_LOGW(TAG, "DrawRectangle (%d,%d)->(%d,%d) exceeds display range", Xstart, Ystart, Xend, Yend);
+        return;
+    }
+    Paint_DrawRectangle_S_Ctx(P, Xstart, Ystart, Xend, Yend, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawRectangle_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Draw a rectangle at signed coordinates
+parameter:
+    Xstart ：Rectangular  Starting Xpoint point coordinates
+    Ystart ：Rectangular  Starting Xpoint point coordinates
+    Xend   ：Rectangular  End point Xpoint coordinate
+    Yend   ：Rectangular  End point Ypoint coordinate
+    Color  ：The color of the Rectangular segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the rectangle
+******************************************************************************/
+void Paint_DrawRectangle_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend,
+                                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Draw_Fill)
+    {
+        // Same area as one Paint_DrawLine per row Ystart..Yend-1: each line
+        // point stamps a (2 * Line_width - 1) square offset by -Line_width
+        if (Yend > Ystart)
+        {
+            int Xmin = (Xstart < Xend) ? Xstart : Xend;
+            int Xmax = (Xstart < Xend) ? Xend : Xstart;
+            Paint_FillRectClipped(P, Xmin - Line_width, Ystart - Line_width,
+                                  Xmax + Line_width - 2, Yend + Line_width - 3, Color);
+        }
+    }
+    else
+    {
+        Paint_DrawLine_S_Ctx(P, Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_S_Ctx(P, Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_S_Ctx(P, Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_DrawLine_S_Ctx(P, Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+    }
+}
+
+void Paint_DrawRectangle_S(int Xstart, int Ystart, int Xend, int Yend,
+                           UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawRectangle_S_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Use the 8-point method to draw a circle of the
+            specified size at the specified position->
+parameter:
+    X_Center  ：Center X coordinate
+    Y_Center  ：Center Y coordinate
+    Radius    ：circle Radius
+    Color     ：The color of the ：circle segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the Circle
+******************************************************************************/
+void Paint_DrawCircle_Ctx(PAINT *P, UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                                    UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (X_Center > P->Width || Y_Center >= P->Height)
+    {
+        ESP_LOGW(TAG, "DrawCircle at (%d,%d) radius %d exceeds display range", X_Center, Y_Center, Radius);
+        return;
+    }
+    Paint_DrawCircle_S_Ctx(P, X_Center, Y_Center, Radius, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                      UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawCircle_Ctx(&Paint, X_Center, Y_Center, Radius, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Half width of an ellipse on one row
+parameter:
+    Rx, Ry : Radii, a pixel is inside when it lies within Rx + 0.5, Ry + 0.5
+    Dy     : Row offset from the center
+info:
+    Returns the largest Dx of a pixel inside the ellipse on row Dy, -1 when
+    the row misses it or a radius is negative.
+******************************************************************************/
+static int Paint_EllipseSpan(int Rx, int Ry, int Dy)
+{
+    if (Rx < 0 || Ry < 0 || Dy > Ry || Dy < -Ry)
+        return -1;
+
+    // (2 Dx)^2 (2 Ry + 1)^2 + (2 Dy)^2 (2 Rx + 1)^2 <= (2 Rx + 1)^2 (2 Ry + 1)^2
+    uint64_t A = 2 * (uint64_t)Rx + 1, B = 2 * (uint64_t)Ry + 1;
+    uint64_t Q = A * A * (B * B - 4 * (uint64_t)Dy * Dy) / (4 * B * B);
+    uint64_t X = (uint64_t)sqrt((double)Q);
+    while (X * X > Q)
+        X--;
+    while ((X + 1) * (X + 1) <= Q)
+        X++;
+    return X;
+}
+
+/******************************************************************************
+function: Split one row of a ring into spans
+parameter:
+    OL, OR : Outer span of the row
+    IL, IR : Hole on the row, IL > IR when there is none
+    NL, NR : Outer span of the next row out, NL > NR when there is none
+    Spans  : Receives up to two [Xstart, Xend] pairs
+info:
+    Returns the number of spans. Each side keeps its end pixel and reaches
+    in at least as far as the next row out ends, so steep parts of a thin
+    ring stay connected.
+******************************************************************************/
+static UBYTE Paint_RingRow(int OL, int OR, int IL, int IR, int NL, int NR, int *Spans)
+{
+    Spans[0] = OL;
+    Spans[1] = OR;
+    if (IL > IR)
+        return 1;
+
+    int Lend = IL - 1, Rstart = IR + 1;
+    if (NL <= NR)
+    {
+        if (Lend < NL - 1)
+            Lend = NL - 1;
+        if (Rstart > NR + 1)
+            Rstart = NR + 1;
+    }
+    if (Lend < OL)
+        Lend = OL;
+    if (Rstart > OR)
+        Rstart = OR;
+    if (Lend + 1 >= Rstart)
+        return 1;
+
+    Spans[1] = Lend;
+    Spans[2] = Rstart;
+    Spans[3] = OR;
+    return 2;
+}
+
+/******************************************************************************
+function: Fill an elliptic ring one span per row
+parameter:
+    X_Center, Y_Center : Center
+    Rx, Ry             : Outer radii
+    HoleRx, HoleRy     : Radii of the hole, negative for a solid ellipse
+    Color              : Painted color
+info:
+    Only the rows inside the clip rectangle are computed.
+******************************************************************************/
+static void Paint_FillRing(PAINT *P, int X_Center, int Y_Center, int Rx, int Ry,
+                                     int HoleRx, int HoleRy, UWORD Color)
+{
+    int Dy0 = P->Clip.Ystart - Y_Center, Dy1 = P->Clip.Yend - 1 - Y_Center;
+    if (Dy0 < -Ry)
+        Dy0 = -Ry;
+    if (Dy1 > Ry)
+        Dy1 = Ry;
+    if (X_Center + Rx < P->Clip.Xstart || X_Center - Rx >= P->Clip.Xend)
+        return;
+
+    for (int Dy = Dy0; Dy <= Dy1; Dy++)
+    {
+        int Outer = Paint_EllipseSpan(Rx, Ry, Dy);
+        int Inner = Paint_EllipseSpan(HoleRx, HoleRy, Dy);
+        int Next = Paint_EllipseSpan(Rx, Ry, (Dy < 0) ? Dy - 1 : Dy + 1);
+        int Spans[4];
+        UBYTE Count = Paint_RingRow(X_Center - Outer, X_Center + Outer, X_Center - Inner, X_Center + Inner,
+                                    X_Center - Next, X_Center + Next, Spans);
+        for (UBYTE i = 0; i < Count; i++)
+            Paint_FillRectClipped(P, Spans[2 * i], Y_Center + Dy, Spans[2 * i + 1], Y_Center + Dy, Color);
+    }
+}
+
+/******************************************************************************
+function: Draw a circle at signed coordinates
+parameter:
+    X_Center  ：Center X coordinate
+    Y_Center  ：Center Y coordinate
+    Radius    ：circle Radius
+    Color     ：The color of the ：circle segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the Circle
+info:
+    A circle that misses the clip rectangle returns before any point is
+    computed. The filled circle is the midpoint circle written as one span
+    per row, an outline wider than one pixel is a ring Line_width - 1
+    pixels either side of the radius. Both write each pixel once.
+******************************************************************************/
+void Paint_DrawCircle_S_Ctx(PAINT *P, int X_Center, int Y_Center, int Radius,
+                                      UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Radius < 0)
+        return;
+
+    int Reach = Radius + Line_width;
+    if (X_Center + Reach < P->Clip.Xstart || X_Center - Reach >= P->Clip.Xend ||
+        Y_Center + Reach < P->Clip.Ystart || Y_Center - Reach >= P->Clip.Yend)
+        return;
+
+    // An outline running around the whole clip rectangle leaves it untouched
+    if (Draw_Fill != DRAW_FILL_FULL)
+    {
+        int64_t FarX = abs(P->Clip.Xstart - X_Center), FarY = abs(P->Clip.Ystart - Y_Center);
+        if (abs(P->Clip.Xend - X_Center) > FarX)
+            FarX = abs(P->Clip.Xend - X_Center);
+        if (abs(P->Clip.Yend - Y_Center) > FarY)
+            FarY = abs(P->Clip.Yend - Y_Center);
+        int64_t Inner = (int64_t)Radius - 2 * Line_width - 2;
+        if (Inner > 0 && FarX * FarX + FarY * FarY < Inner * Inner)
+            return;
+    }
+
+    // Points are drawn offset by (-1, -1), as Paint_DrawPoint does
+    int X = X_Center - 1, Y = Y_Center - 1;
+
+    if (Draw_Fill != DRAW_FILL_FULL && Line_width > DOT_PIXEL_1X1)
+    {
+        Paint_FillRing(P, X, Y, Radius + Line_width - 1, Radius + Line_width - 1,
+                       Radius - Line_width, Radius - Line_width, Color);
+        return;
+    }
+
+    // Draw a circle from(0, R) as a starting point
+    int XCurrent, YCurrent;
+    XCurrent = 0;
+    YCurrent = Radius;
+
+    // Cumulative error,judge the next point of the logo
+    int Esp = 3 - (Radius << 1);
+
+    if (Draw_Fill == DRAW_FILL_FULL)
+    {
+        while (XCurrent <= YCurrent)
+        { // Realistic circles, rows +-XCurrent reach out to YCurrent
+            Paint_FillRectClipped(P, X - YCurrent, Y + XCurrent, X + YCurrent, Y + XCurrent, Color);
+            if (XCurrent)
+                Paint_FillRectClipped(P, X - YCurrent, Y - XCurrent, X + YCurrent, Y - XCurrent, Color);
+            if (Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else
+            {
+                // Rows +-YCurrent get no wider, they reach out to XCurrent
+                if (YCurrent > XCurrent)
+                {
+                    Paint_FillRectClipped(P, X - XCurrent, Y + YCurrent, X + XCurrent, Y + YCurrent, Color);
+                    Paint_FillRectClipped(P, X - XCurrent, Y - YCurrent, X + XCurrent, Y - YCurrent, Color);
+                }
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+    }
+    else
+    { // Draw a hollow circle
+        while (XCurrent <= YCurrent)
+        {
+            Paint_SetPixel_S_Ctx(P, X + XCurrent, Y + YCurrent, Color); // 1
+            Paint_SetPixel_S_Ctx(P, X - XCurrent, Y + YCurrent, Color); // 2
+            Paint_SetPixel_S_Ctx(P, X - YCurrent, Y + XCurrent, Color); // 3
+            Paint_SetPixel_S_Ctx(P, X - YCurrent, Y - XCurrent, Color); // 4
+            Paint_SetPixel_S_Ctx(P, X - XCurrent, Y - YCurrent, Color); // 5
+            Paint_SetPixel_S_Ctx(P, X + XCurrent, Y - YCurrent, Color); // 6
+            Paint_SetPixel_S_Ctx(P, X + YCurrent, Y - XCurrent, Color); // 7
+            Paint_SetPixel_S_Ctx(P, X + YCurrent, Y + XCurrent, Color); // 0
+
+            if (Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else
+            {
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+    }
+}
+
+void Paint_DrawCircle_S(int X_Center, int Y_Center, int Radius,
+                        UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawCircle_S_Ctx(&Paint, X_Center, Y_Center, Radius, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Draw an ellipse
+parameter:
+    X_Center  ：Center X coordinate
+    Y_Center  ：Center Y coordinate
+    X_Radius  ：Horizontal radius
+    Y_Radius  ：Vertical radius
+    Color     ：The color of the ellipse
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the ellipse
+******************************************************************************/
+void Paint_DrawEllipse_Ctx(PAINT *P, UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius,
+                                     UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (X_Center > P->Width || Y_Center >= P->Height)
+    {
+        ESP_LOGW(TAG, "DrawEllipse at (%d,%d) exceeds display range", X_Center, Y_Center);
+        return;
+    }
+    Paint_DrawEllipse_S_Ctx(P, X_Center, Y_Center, X_Radius, Y_Radius, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawEllipse(UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius,
+                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawEllipse_Ctx(&Paint, X_Center, Y_Center, X_Radius, Y_Radius, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Draw an ellipse at signed coordinates
+parameter:
+    X_Center  ：Center X coordinate
+    Y_Center  ：Center Y coordinate
+    X_Radius  ：Horizontal radius
+    Y_Radius  ：Vertical radius
+    Color     ：The color of the ellipse
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the ellipse
+info:
+    Placed like Paint_DrawCircle, offset by (-1, -1). The outline is a ring
+    2 * Line_width - 1 pixels wide around the radii. Radii above 16383 are
+    not supported.
+******************************************************************************/
+void Paint_DrawEllipse_S_Ctx(PAINT *P, int X_Center, int Y_Center, int X_Radius, int Y_Radius,
+                                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (X_Radius < 0 || Y_Radius < 0 || X_Radius > 16383 || Y_Radius > 16383)
+        return;
+
+    if (Draw_Fill == DRAW_FILL_FULL)
+    {
+        Paint_FillRing(P, X_Center - 1, Y_Center - 1, X_Radius, Y_Radius, -1, -1, Color);
+    }
+    else
+    {
+        Paint_FillRing(P, X_Center - 1, Y_Center - 1, X_Radius + Line_width - 1, Y_Radius + Line_width - 1,
+                       X_Radius - Line_width, Y_Radius - Line_width, Color);
+    }
+}
+
+void Paint_DrawEllipse_S(int X_Center, int Y_Center, int X_Radius, int Y_Radius,
+                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawEllipse_S_Ctx(&Paint, X_Center, Y_Center, X_Radius, Y_Radius, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Polygon edge, stored from its upper end point
+******************************************************************************/
+typedef struct
+{
+    int X0, Y0; // Upper end point
+    int Dx, Dy; // Lower end point minus the upper one, Dy >= 0
+} PAINT_EDGE;
+
+// Work area per vertex: edge, active entry, crossing and 2 spans
+#define PAINT_POLY_POINT_BYTES (sizeof(PAINT_EDGE) + sizeof(UWORD) + 2 * sizeof(int64_t) + 4 * sizeof(int))
+
+/******************************************************************************
+function: Fill a polygon with an active edge table
+parameter:
+    Points : Vertices, the last one joins back to the first
+    Count  : Number of vertices
+    Color  : Painted color
+info:
+    Uses the even-odd rule. A pixel is painted when its center lies inside
+    the polygon or on its boundary, so a polygon covers the same pixels as
+    its 1 pixel outline. Vertices are offset by (-1, -1) like every other
+    primitive. Edges enter the active table at their upper row and leave
+    after their lower one; every row of the clip rectangle the polygon
+    crosses is written as merged spans, each pixel once.
+    Up to PAINT_POLY_STACK_POINTS vertices the work area is on the stack,
+    larger polygons allocate Count * PAINT_POLY_POINT_BYTES for the call.
+******************************************************************************/
+void Paint_FillPolygon_Ctx(PAINT *P, const PAINT_POINT *Points, UWORD Count, UWORD Color)
+{
+    if (Points == NULL || Count == 0)
+        return;
+
+    int Ymin = Points[0].Y, Ymax = Points[0].Y, Xmin = Points[0].X, Xmax = Points[0].X;
+    for (UWORD i = 1; i < Count; i++)
+    {
+        if (Points[i].Y < Ymin)
+            Ymin = Points[i].Y;
+        if (Points[i].Y > Ymax)
+            Ymax = Points[i].Y;
+        if (Points[i].X < Xmin)
+            Xmin = Points[i].X;
+        if (Points[i].X > Xmax)
+            Xmax = Points[i].X;
+    }
+    Ymin -= 1, Ymax -= 1, Xmin -= 1, Xmax -= 1;
+    if (Xmax < P->Clip.Xstart || Xmin >= P->Clip.Xend ||
+        Ymax < P->Clip.Ystart || Ymin >= P->Clip.Yend)
+        return;
+    if (Ymin < P->Clip.Ystart)
+        Ymin = P->Clip.Ystart;
+    if (Ymax > P->Clip.Yend - 1)
+        Ymax = P->Clip.Yend - 1;
+
+    // Edges, the active table, crossings (numerator / denominator) and spans
+    int64_t Stack[(PAINT_POLY_STACK_POINTS * PAINT_POLY_POINT_BYTES + 7) / 8];
+    UBYTE *Work = (UBYTE *)Stack;
+    if (Count > PAINT_POLY_STACK_POINTS)
+    {
+        UDOUBLE Bytes = (UDOUBLE)Count * PAINT_POLY_POINT_BYTES;
+        Work = (UBYTE *)malloc(Bytes);
+        if (Work == NULL)
+        {
+            ESP_LOGE(TAG, "Failed to allocate %lu bytes for a %d point polygon", (unsigned long)Bytes, Count);
+            return;
+        }
+    }
+    PAINT_EDGE *Edges = (PAINT_EDGE *)Work;
+    int64_t *Num = (int64_t *)(Edges + Count);
+    int64_t *Den = Num + Count;
+    int *Spans = (int *)(Den + Count);
+    UWORD *Active = (UWORD *)(Spans + 4 * Count);
+
+    // Build the edge table sorted by upper row
+    for (UWORD i = 0; i < Count; i++)
+    {
+        const PAINT_POINT *A = &Points[i], *B = &Points[(i + 1) % Count];
+        if (B->Y < A->Y)
+        {
+            const PAINT_POINT *T = A;
+            A = B;
+            B = T;
+        }
+        PAINT_EDGE E = {A->X - 1, A->Y - 1, B->X - A->X, B->Y - A->Y};
+        UWORD j = i;
+        while (j > 0 && Edges[j - 1].Y0 > E.Y0)
+        {
+            Edges[j] = Edges[j - 1];
+            j--;
+        }
+        Edges[j] = E;
+    }
+
+    UWORD Next = 0, NActive = 0;
+    for (int Y = Ymin; Y <= Ymax; Y++)
+    {
+        // Edges reaching this row join, the ones ending above it leave
+        while (Next < Count && Edges[Next].Y0 <= Y)
+            Active[NActive++] = Next++;
+        UWORD Kept = 0;
+        for (UWORD i = 0; i < NActive; i++)
+            if (Edges[Active[i]].Y0 + Edges[Active[i]].Dy >= Y)
+                Active[Kept++] = Active[i];
+        NActive = Kept;
+
+        // Crossings of edges holding the row in [Y0, Y0 + Dy), sorted by X
+        UWORD NCross = 0, NSpans = 0;
+        for (UWORD i = 0; i < NActive; i++)
+        {
+            const PAINT_EDGE *E = &Edges[Active[i]];
+            if (E->Dy == 0)
+            { // Horizontal edges lie on the boundary
+                Spans[2 * NSpans] = (E->Dx < 0) ? E->X0 + E->Dx : E->X0;
+                Spans[2 * NSpans + 1] = (E->Dx < 0) ? E->X0 : E->X0 + E->Dx;
+                NSpans++;
+                continue;
+            }
+            if (Y == E->Y0 + E->Dy)
+            { // So does the lower end point
+                Spans[2 * NSpans] = Spans[2 * NSpans + 1] = E->X0 + E->Dx;
+                NSpans++;
+                continue;
+            }
+            int64_t N = (int64_t)E->X0 * E->Dy + (int64_t)(Y - E->Y0) * E->Dx;
+            UWORD j = NCross;
+            while (j > 0 && Num[j - 1] * E->Dy > N * Den[j - 1])
+            {
+                Num[j] = Num[j - 1];
+                Den[j] = Den[j - 1];
+                j--;
+            }
+            Num[j] = N;
+            Den[j] = E->Dy;
+            NCross++;
+        }
+
+        // Inside between each pair, pixel centers on the crossings included
+        for (UWORD i = 0; i + 1 < NCross; i += 2)
+        {
+            int Xs = (int)-Paint_DivFloor(-Num[i], Den[i]);
+            int Xe = (int)Paint_DivFloor(Num[i + 1], Den[i + 1]);
+            if (Xs <= Xe)
+            {
+                Spans[2 * NSpans] = Xs;
+                Spans[2 * NSpans + 1] = Xe;
+                NSpans++;
+            }
+        }
+
+        // Merge touching spans so each pixel is written once
+        for (UWORD i = 1; i < NSpans; i++)
+        {
+            int S0 = Spans[2 * i], S1 = Spans[2 * i + 1];
+            UWORD j = i;
+            while (j > 0 && Spans[2 * (j - 1)] > S0)
+            {
+                Spans[2 * j] = Spans[2 * (j - 1)];
+                Spans[2 * j + 1] = Spans[2 * (j - 1) + 1];
+                j--;
+            }
+            Spans[2 * j] = S0;
+            Spans[2 * j + 1] = S1;
+        }
+        for (UWORD i = 0; i < NSpans;)
+        {
+            int Xs = Spans[2 * i], Xe = Spans[2 * i + 1];
+            for (i++; i < NSpans && Spans[2 * i] <= Xe + 1; i++)
+                if (Spans[2 * i + 1] > Xe)
+                    Xe = Spans[2 * i + 1];
+            Paint_FillRectClipped(P, Xs, Y, Xe, Y, Color);
+        }
+    }
+    if (Work != (UBYTE *)Stack)
+    {
+        free(Work);
+    }
+}
+
+void Paint_FillPolygon(const PAINT_POINT *Points, UWORD Count, UWORD Color)
+{
+    Paint_FillPolygon_Ctx(&Paint, Points, Count, Color);
+}
+
+/******************************************************************************
+function: Draw a polygon outline
+parameter:
+    Points    : Vertices, the last one joins back to the first
+    Count     : Number of vertices
+    Color     : Painted color
+    Line_width: Line width
+info:
+    Each edge is drawn as Paint_DrawLine_S draws a solid line.
+******************************************************************************/
+void Paint_DrawPolygon_Ctx(PAINT *P, const PAINT_POINT *Points, UWORD Count, UWORD Color, DOT_PIXEL Line_width)
+{
+    if (Points == NULL)
+        return;
+    for (UWORD i = 0; i < Count; i++)
+    {
+        const PAINT_POINT *A = &Points[i], *B = &Points[(i + 1) % Count];
+        Paint_DrawLine_S_Ctx(P, A->X, A->Y, B->X, B->Y, Color, Line_width, LINE_STYLE_SOLID);
+    }
+}
+
+void Paint_DrawPolygon(const PAINT_POINT *Points, UWORD Count, UWORD Color, DOT_PIXEL Line_width)
+{
+    Paint_DrawPolygon_Ctx(&Paint, Points, Count, Color, Line_width);
+}
+
+/******************************************************************************
+function: Fill a triangle
+parameter:
+    X0, Y0, X1, Y1, X2, Y2 : Vertices
+    Color                  : Painted color
+******************************************************************************/
+void Paint_FillTriangle_Ctx(PAINT *P, int X0, int Y0, int X1, int Y1, int X2, int Y2, UWORD Color)
+{
+    PAINT_POINT Points[3] = {{X0, Y0}, {X1, Y1}, {X2, Y2}};
+    Paint_FillPolygon_Ctx(P, Points, 3, Color);
+}
+
+void Paint_FillTriangle(int X0, int Y0, int X1, int Y1, int X2, int Y2, UWORD Color)
+{
+    Paint_FillTriangle_Ctx(&Paint, X0, Y0, X1, Y1, X2, Y2, Color);
+}
+
+/******************************************************************************
+function: Span of a rounded rectangle on one row
+parameter:
+    Xstart, Ystart, Xend, Yend : Corner pixels, inclusive
+    Radius                     : Corner radius, at most half the shorter side
+    Y                          : Row
+    Xs, Xe                     : Receive the span
+info:
+    Returns 0 when the row misses the rectangle. Corners are quarter discs
+    with the same edge as Paint_DrawEllipse.
+******************************************************************************/
+static UBYTE Paint_RoundRectSpan(int Xstart, int Ystart, int Xend, int Yend, int Radius,
+                                 int Y, int *Xs, int *Xe)
+{
+    if (Y < Ystart || Y > Yend || Xstart > Xend)
+        return 0;
+
+    int Dy = 0;
+    if (Y < Ystart + Radius)
+        Dy = Ystart + Radius - Y;
+    else if (Y > Yend - Radius)
+        Dy = Y - (Yend - Radius);
+    int Inset = Radius - Paint_EllipseSpan(Radius, Radius, Dy);
+    *Xs = Xstart + Inset;
+    *Xe = Xend - Inset;
+    return 1;
+}
+
+/******************************************************************************
+function: Draw a rectangle with rounded corners
+parameter:
+    Xstart    ：Rectangle Start X coordinate
+    Ystart    ：Rectangle Start Y coordinate
+    Xend      ：Rectangle End X coordinate
+    Yend      ：Rectangle End Y coordinate
+    Radius    ：Corner radius
+    Color     ：The color of the Rectangle segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the rectangle
+info:
+    Both corners are inclusive and offset by (-1, -1). The outline is
+    centered on the edges like the one of Paint_DrawRectangle, reaching
+    Line_width - 1 pixels to either side. The radius is clamped to half
+    the shorter side.
+******************************************************************************/
+void Paint_DrawRoundRect_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, int Radius,
+                                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Xstart > Xend)
+    {
+        int T = Xstart;
+        Xstart = Xend;
+        Xend = T;
+    }
+    if (Ystart > Yend)
+    {
+        int T = Ystart;
+        Ystart = Yend;
+        Yend = T;
+    }
+    Xstart -= 1, Ystart -= 1, Xend -= 1, Yend -= 1;
+    if (Radius < 0)
+        Radius = 0;
+    if (Radius > (Xend - Xstart) / 2)
+        Radius = (Xend - Xstart) / 2;
+    if (Radius > (Yend - Ystart) / 2)
+        Radius = (Yend - Ystart) / 2;
+
+    // Outer shape and hole
+    int Grow = (Draw_Fill == DRAW_FILL_FULL) ? 0 : Line_width - 1;
+    int OX0 = Xstart - Grow, OY0 = Ystart - Grow, OX1 = Xend + Grow, OY1 = Yend + Grow, OR = Radius + Grow;
+    int IX0 = Xstart + Line_width, IY0 = Ystart + Line_width, IX1 = Xend - Line_width, IY1 = Yend - Line_width;
+    int IR = (Radius > Line_width) ? Radius - Line_width : 0;
+
+    int Y0 = (OY0 > P->Clip.Ystart) ? OY0 : P->Clip.Ystart;
+    int Y1 = (OY1 < P->Clip.Yend - 1) ? OY1 : P->Clip.Yend - 1;
+    if (OX1 < P->Clip.Xstart || OX0 >= P->Clip.Xend)
+        return;
+
+    for (int Y = Y0; Y <= Y1; Y++)
+    {
+        int OL, ORt, IL = 1, IRt = 0, NL = 1, NR = 0;
+        Paint_RoundRectSpan(OX0, OY0, OX1, OY1, OR, Y, &OL, &ORt);
+        if (Draw_Fill != DRAW_FILL_FULL)
+        {
+            Paint_RoundRectSpan(IX0, IY0, IX1, IY1, IR, Y, &IL, &IRt);
+            Paint_RoundRectSpan(OX0, OY0, OX1, OY1, OR, (Y < (OY0 + OY1) / 2) ? Y - 1 : Y + 1, &NL, &NR);
+        }
+        int Spans[4];
+        UBYTE Count = Paint_RingRow(OL, ORt, IL, IRt, NL, NR, Spans);
+        for (UBYTE i = 0; i < Count; i++)
+            Paint_FillRectClipped(P, Spans[2 * i], Y, Spans[2 * i + 1], Y, Color);
+    }
+}
+
+void Paint_DrawRoundRect(int Xstart, int Ystart, int Xend, int Yend, int Radius,
+                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_DrawRoundRect_Ctx(&Paint, Xstart, Ystart, Xend, Yend, Radius, Color, Line_width, Draw_Fill);
+}
+
+/******************************************************************************
+function: Bounds one half plane of an arc sector puts on a row
+parameter:
+    Ux, Uy : Direction of the sector edge
+    Dy     : Row offset from the center
+    Open   : Leave out the edge of the half plane
+    Lo, Hi : Narrowed to the offsets Dx with Ux * Dy - Uy * Dx >= 0
+info:
+    Only matters for a horizontal edge: otherwise the caller decides how to
+    round Lo and Hi.
+******************************************************************************/
+static void Paint_ArcBound(float Ux, float Uy, int Dy, UBYTE Open, float *Lo, float *Hi)
+{
+    const float Eps = 1e-4f;
+    if (fabsf(Uy) < Eps)
+    {
+        if (Open ? (Ux * Dy <= Eps) : (Ux * Dy < -Eps))
+            *Lo = 1, *Hi = 0;
+        return;
+    }
+    float T = Ux * Dy / Uy;
+    if (Uy > 0)
+    {
+        if (T < *Hi)
+            *Hi = T;
+    }
+    else if (T > *Lo)
+    {
+        *Lo = T;
+    }
+}
+
+/******************************************************************************
+function: Draw an arc of a circle
+parameter:
+    X_Center   ：Center X coordinate
+    Y_Center   ：Center Y coordinate
+    Radius     ：Arc radius
+    Start_Angle：Start angle in degrees, 0 points right
+    End_Angle  ：End angle in degrees, increasing angles run clockwise
+    Color      ：The color of the arc
+    Line_width : Line width
+info:
+    The arc is the part of the Paint_DrawEllipse outline whose pixel centers
+    lie in the sector swept clockwise from Start_Angle to End_Angle; a sweep
+    of 360 degrees or more draws the whole circle. Each row of the ring is
+    cut to the sector with two half planes, so cost follows the pixels drawn.
+******************************************************************************/
+void Paint_DrawArc_Ctx(PAINT *P, int X_Center, int Y_Center, int Radius, int Start_Angle, int End_Angle,
+                                 UWORD Color, DOT_PIXEL Line_width)
+{
+    if (Radius < 0 || Radius > 16383)
+        return;
+
+    int Sweep = End_Angle - Start_Angle;
+    if (Sweep >= 360)
+    {
+        Paint_DrawEllipse_S_Ctx(P, X_Center, Y_Center, Radius, Radius, Color, Line_width, DRAW_FILL_EMPTY);
+        return;
+    }
+    Sweep = ((Sweep % 360) + 360) % 360;
+    if (Sweep == 0)
+        return;
+
+    float Sx = cosf(Start_Angle * (float)M_PI / 180), Sy = sinf(Start_Angle * (float)M_PI / 180);
+    float Ex = cosf(End_Angle * (float)M_PI / 180), Ey = sinf(End_Angle * (float)M_PI / 180);
+
+    // The ring Paint_DrawEllipse_S draws, offset by (-1, -1)
+    int Xc = X_Center - 1, Yc = Y_Center - 1;
+    int Rx = Radius + Line_width - 1, Hole = Radius - Line_width;
+
+    int Dy0 = P->Clip.Ystart - Yc, Dy1 = P->Clip.Yend - 1 - Yc;
+    if (Dy0 < -Rx)
+        Dy0 = -Rx;
+    if (Dy1 > Rx)
+        Dy1 = Rx;
+    if (Xc + Rx < P->Clip.Xstart || Xc - Rx >= P->Clip.Xend)
+        return;
+
+    for (int Dy = Dy0; Dy <= Dy1; Dy++)
+    {
+        int Outer = Paint_EllipseSpan(Rx, Rx, Dy);
+        int Inner = Paint_EllipseSpan(Hole, Hole, Dy);
+        int Next = Paint_EllipseSpan(Rx, Rx, (Dy < 0) ? Dy - 1 : Dy + 1);
+        int Spans[4];
+        UBYTE Count = Paint_RingRow(-Outer, Outer, -Inner, Inner, -Next, Next, Spans);
+
+        // Offsets Dx inside the sector: one interval, or all but one gap
+        float Lo = -Rx - 1, Hi = Rx + 1;
+        UBYTE Gap = Sweep > 180;
+        if (Gap)
+        { // Cut away the sector running from End_Angle on to Start_Angle
+            Paint_ArcBound(Ex, Ey, Dy, 1, &Lo, &Hi);
+            Paint_ArcBound(-Sx, -Sy, Dy, 1, &Lo, &Hi);
+        }
+        else
+        {
+            Paint_ArcBound(Sx, Sy, Dy, 0, &Lo, &Hi);
+            Paint_ArcBound(-Ex, -Ey, Dy, 0, &Lo, &Hi);
+        }
+        int Ls = (int)ceilf(Lo - 1e-3f), Hs = (int)floorf(Hi + 1e-3f);
+
+        for (UBYTE i = 0; i < Count; i++)
+        {
+            int Xs = Spans[2 * i], Xe = Spans[2 * i + 1];
+            if (!Gap)
+            {
+                Paint_FillRectClipped(P, Xc + ((Xs > Ls) ? Xs : Ls), Yc + Dy, Xc + ((Xe < Hs) ? Xe : Hs), Yc + Dy, Color);
+                continue;
+            }
+            // The gap is open: pixel centers on its edges stay
+            int Gs = (int)floorf(Lo + 1e-3f) + 1, Ge = (int)ceilf(Hi - 1e-3f) - 1;
+            if (Gs > Ge)
+            {
+                Paint_FillRectClipped(P, Xc + Xs, Yc + Dy, Xc + Xe, Yc + Dy, Color);
+                continue;
+            }
+            Paint_FillRectClipped(P, Xc + Xs, Yc + Dy, Xc + ((Xe < Gs - 1) ? Xe : Gs - 1), Yc + Dy, Color);
+            Paint_FillRectClipped(P, Xc + ((Xs > Ge + 1) ? Xs : Ge + 1), Yc + Dy, Xc + Xe, Yc + Dy, Color);
+        }
+    }
+}
+
+void Paint_DrawArc(int X_Center, int Y_Center, int Radius, int Start_Angle, int End_Angle,
+                   UWORD Color, DOT_PIXEL Line_width)
+{
+    Paint_DrawArc_Ctx(&Paint, X_Center, Y_Center, Radius, Start_Angle, End_Angle, Color, Line_width);
+}
+
+/******************************************************************************
+function: Write a run of 1bpp pixels into one buffer row
+parameter:
+    Y           : Buffer row
+    X0          : Buffer column of the first pixel
+    Bits        : Pixels, the first one in bit 31, 1 means foreground
+    Count       : Number of pixels, at most 32
+    Transparent : Leave background pixels untouched
+    Fg, Bg      : Foreground and background bit values, 0 or 1
+******************************************************************************/
+static void Paint_BlitRun(PAINT *P, UWORD Y, UWORD X0, uint32_t Bits, UBYTE Count, UBYTE Transparent, UBYTE Fg, UBYTE Bg)
+{
+    uint32_t Run = (Count >= 32) ? 0xFFFFFFFF : ~(0xFFFFFFFF >> Count);
+    uint32_t Value = (Fg ? Bits : 0) | (Bg ? (~Bits & Run) : 0);
+    uint32_t Mask = Transparent ? Bits : Run;
+
+    // Line the run up with the byte grid: bit 63 is the first pixel of byte X0 / 8
+    UBYTE Shift = X0 % 8;
+    uint64_t V = ((uint64_t)Value << 32) >> Shift;
+    uint64_t M = ((uint64_t)Mask << 32) >> Shift;
+    UBYTE *Row = &PAINT_ROW(P, Y)[X0 / 8];
+    for (UBYTE k = 0; k < (Shift + Count + 7) / 8; k++)
+    {
+        UBYTE Mb = (UBYTE)(M >> (56 - 8 * k));
+        Row[k] = (Row[k] & ~Mb) | ((UBYTE)(V >> (56 - 8 * k)) & Mb);
+    }
+}
+
+/******************************************************************************
+function: Reverse the bit order of a 32-bit word
+parameter:
+    x : Word to reverse
+******************************************************************************/
+static inline uint32_t Paint_Reverse32(uint32_t x)
+{
+    x = ((x >> 1) & 0x55555555) | ((x & 0x55555555) << 1);
+    x = ((x >> 2) & 0x33333333) | ((x & 0x33333333) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F) | ((x & 0x0F0F0F0F) << 4);
+    x = ((x >> 8) & 0x00FF00FF) | ((x & 0x00FF00FF) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+/******************************************************************************
+function: Read a glyph as one word per row
+parameter:
+    ptr    : Glyph in the font table
+    Font   : Font of the glyph
+    Rows   : Filled with Font->Height words, the first column in bit 31,
+             then zero up to the next multiple of 8 rows
+******************************************************************************/
+static void Paint_GlyphRows(const unsigned char *ptr, const sFONT *Font, uint32_t *Rows)
+{
+    UWORD RowBytes = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+    UWORD Page;
+    for (Page = 0; Page < Font->Height; Page++)
+    {
+        uint32_t Word = 0;
+        for (UWORD b = 0; b < RowBytes; b++)
+        {
+            Word |= (uint32_t)ptr[Page * RowBytes + b] << (24 - 8 * b);
+        }
+        Rows[Page] = Word;
+    }
+    for (; Page % 8; Page++)
+    {
+        Rows[Page] = 0;
+    }
+}
+
+/******************************************************************************
+function: Turn glyph rows into glyph columns
+parameter:
+    Rows   : Output of Paint_GlyphRows
+    Font   : Font of the glyph
+    Cols   : Filled with Font->Width words, the first row in bit 31
+info:
+    Works in 8x8 blocks: 8 rows of one font byte column in, 8 columns out.
+******************************************************************************/
+static void Paint_TransposeGlyph(const uint32_t *Rows, const sFONT *Font, uint32_t *Cols)
+{
+    UWORD ColBytes = (Font->Width + 7) / 8;
+    memset(Cols, 0, ColBytes * 8 * sizeof(uint32_t));
+    for (UWORD Page = 0; Page < Font->Height; Page += 8)
+    {
+        for (UWORD b = 0; b < ColBytes; b++)
+        {
+            UBYTE Shift = 24 - 8 * b;
+            uint64_t Block = 0;
+            for (UWORD k = 0; k < 8; k++)
+            {
+                Block = (Block << 8) | ((Rows[Page + k] >> Shift) & 0xFF);
+            }
+            Block = Frame_Transpose8x8(Block);
+            for (UWORD k = 0; k < 8; k++)
+            {
+                Cols[b * 8 + k] |= (uint32_t)((Block >> (56 - 8 * k)) & 0xFF) << (24 - Page);
+            }
+        }
+    }
+}
+
+/**
+ * Glyphs transposed for ROTATE_90/270, built on first use per font
+ **/
+#define PAINT_GLYPH_CACHE_FONTS 5
+#define PAINT_GLYPH_COUNT 95 // ' ' to '~'
+
+typedef struct
+{
+    const sFONT *Font;
+    UBYTE *Cols; // Per glyph, Font->Width columns of (Font->Height + 7) / 8 bytes
+} PAINT_GLYPH_CACHE;
+
+static PAINT_GLYPH_CACHE Paint_GlyphCache[PAINT_GLYPH_CACHE_FONTS];
+static UBYTE Paint_GlyphCacheOn;
 
-    for (;;)
+/******************************************************************************
+function: Enable the rotated glyph cache
+parameter:
+    Enable : 1 to transpose fonts on first use in ROTATE_90/270, 0 to free
+info:
+    Costs 95 x Width x ((Height + 7) / 8) bytes per font used, 4845 bytes
+    for Font24. Don't call it while any context is drawing.
+******************************************************************************/
+void Paint_SetGlyphCache(UBYTE Enable)
+{
+    if (!Enable)
     {
-        Dotted_Len++;
-        // Painted dotted line, 2 point is really virtual
-        if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0)
+        for (UWORD i = 0; i < PAINT_GLYPH_CACHE_FONTS; i++)
         {
-            // Debug("LINE_DOTTED\r\n");
-            Paint_DrawPoint(Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
-            Dotted_Len = 0;
-        }
-        else
-        {
-            Paint_DrawPoint(Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
-        }
-        if (2 * Esp >= dy)
-        {
-            if (Xpoint == Xend)
-                break;
-            Esp += dy;
-            Xpoint += XAddway;
-        }
-        if (2 * Esp <= dx)
-        {
-            if (Ypoint == Yend)
-                break;
-            Esp += dx;
-            Ypoint += YAddway;
+            free(Paint_GlyphCache[i].Cols);
+            Paint_GlyphCache[i].Cols = NULL;
+            Paint_GlyphCache[i].Font = NULL;
         }
     }
+    Paint_GlyphCacheOn = Enable ? 1 : 0;
 }
 
 /******************************************************************************
-function: Draw a rectangle
+function: Columns of a glyph from the rotated glyph cache
 parameter:
-    Xstart ：Rectangular  Starting Xpoint point coordinates
-    Ystart ：Rectangular  Starting Xpoint point coordinates
-    Xend   ：Rectangular  End point Xpoint coordinate
-    Yend   ：Rectangular  End point Ypoint coordinate
-    Color  ：The color of the Rectangular segment
-    Line_width: Line width
-    Draw_Fill : Whether to fill the inside of the rectangle
+    Font  : Font of the glyph
+    Index : Glyph number, character - ' '
+info:
+    Returns NULL when the cache is off or full, or allocation failed.
+    Contexts drawing on other cores share the cache without a lock: a slot
+    is claimed with a compare-and-swap on its font and its columns are
+    published once built. Until then the other tasks get NULL and
+    transpose the glyph themselves.
 ******************************************************************************/
-void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
-                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+static const UBYTE *Paint_GlyphColumns(const sFONT *Font, UWORD Index)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height)
-    {
-        ESP_LOGW(TAG, "DrawRectangle (%d,%d)->(%d,%d) exceeds display range", Xstart, Ystart, Xend, Yend);
-        return;
-    }
+    PAINT_GLYPH_CACHE *Free = NULL;
+    UWORD ColBytes = (Font->Height + 7) / 8;
+    UDOUBLE GlyphBytes = (UDOUBLE)Font->Width * ColBytes;
 
-    if (Draw_Fill)
+    if (!Paint_GlyphCacheOn || Index >= PAINT_GLYPH_COUNT)
+        return NULL;
+
+    for (UWORD i = 0; i < PAINT_GLYPH_CACHE_FONTS; i++)
     {
-        UWORD Ypoint;
-        for (Ypoint = Ystart; Ypoint < Yend; Ypoint++)
+        const sFONT *Owner = __atomic_load_n(&Paint_GlyphCache[i].Font, __ATOMIC_ACQUIRE);
+        if (Owner == Font)
         {
-            Paint_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color, Line_width, LINE_STYLE_SOLID);
+            UBYTE *Table = __atomic_load_n(&Paint_GlyphCache[i].Cols, __ATOMIC_ACQUIRE);
+            return Table ? &Table[Index * GlyphBytes] : NULL;
         }
+        if (Free == NULL && Owner == NULL)
+            Free = &Paint_GlyphCache[i];
     }
-    else
+    if (Free == NULL)
+        return NULL;
+
+    const sFONT *Expected = NULL;
+    if (!__atomic_compare_exchange_n(&Free->Font, &Expected, Font, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return NULL;
+    UBYTE *Table = (UBYTE *)malloc(PAINT_GLYPH_COUNT * GlyphBytes);
+    if (Table == NULL)
+    {
+        ESP_LOGW(TAG, "No memory for rotated glyph cache");
+        __atomic_store_n(&Free->Font, NULL, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    UWORD RowBytes = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+    for (UWORD g = 0; g < PAINT_GLYPH_COUNT; g++)
     {
-        Paint_DrawLine(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        uint32_t Rows[32], Cols[32];
+        Paint_GlyphRows(&Font->table[g * Font->Height * RowBytes], Font, Rows);
+        Paint_TransposeGlyph(Rows, Font, Cols);
+        UBYTE *Out = &Table[g * GlyphBytes];
+        for (UWORD c = 0; c < Font->Width; c++)
+        {
+            for (UWORD b = 0; b < ColBytes; b++)
+            {
+                *Out++ = (UBYTE)(Cols[c] >> (24 - 8 * b));
+            }
+        }
     }
+    __atomic_store_n(&Free->Cols, Table, __ATOMIC_RELEASE);
+    return &Table[Index * GlyphBytes];
 }
 
 /******************************************************************************
-function: Use the 8-point method to draw a circle of the
-            specified size at the specified position->
+function: Blit a glyph into a 1bpp buffer a row or column at a time
 parameter:
-    X_Center  ：Center X coordinate
-    Y_Center  ：Center Y coordinate
-    Radius    ：circle Radius
-    Color     ：The color of the ：circle segment
-    Line_width: Line width
-    Draw_Fill : Whether to fill the inside of the Circle
+    Xpoint, Ypoint : Top-left corner of the glyph
+    C0, C1         : Glyph columns to draw, C1 exclusive
+    R0, R1         : Glyph rows to draw, R1 exclusive
+    Index          : Glyph number, character - ' '
+    Font           : Font of the glyph
+    Transparent    : Leave background pixels untouched
+    Fg, Bg         : Foreground and background colors
+info:
+    When buffer rows run along the glyph rows, each font row is shifted and
+    masked into place. For ROTATE_90/270 each glyph column becomes one
+    buffer row, read from the rotated glyph cache when enabled or
+    transposed on the fly. Mirrored lines are bit reversed.
 ******************************************************************************/
-void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
-                      UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+static void Paint_BlitGlyph(PAINT *P, int Xpoint, int Ypoint, UBYTE C0, UBYTE C1, UBYTE R0, UBYTE R1,
+                                      int Index, sFONT *Font, UBYTE Transparent, UWORD Fg, UWORD Bg)
 {
-    if (X_Center > Paint.Width || Y_Center >= Paint.Height)
-    {
-        ESP_LOGW(TAG, "DrawCircle at (%d,%d) radius %d exceeds display range", X_Center, Y_Center, Radius);
-        return;
-    }
+    UBYTE T = Paint_Transform(P);
+    UWORD RowBytes = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+    UBYTE FgBit = (Fg == BLACK) ? 0 : 1, BgBit = (Bg == BLACK) ? 0 : 1;
+    const unsigned char *ptr = &Font->table[Index * Font->Height * RowBytes];
+    uint32_t Lines[32];
 
-    // Draw a circle from(0, R) as a starting point
-    int16_t XCurrent, YCurrent;
-    XCurrent = 0;
-    YCurrent = Radius;
-
-    // Cumulative error,judge the next point of the logo
-    int16_t Esp = 3 - (Radius << 1);
-
-    int16_t sCountY;
-    if (Draw_Fill == DRAW_FILL_FULL)
+    // Lines First..Last-1 run along buffer rows, Count pixels of each are
+    // drawn after skipping the first Skip
+    UBYTE Count, Skip, First, Last;
+    int Across, Down;
+    if (T & PAINT_SWAP)
     {
-        while (XCurrent <= YCurrent)
-        { // Realistic circles
-            for (sCountY = XCurrent; sCountY <= YCurrent; sCountY++)
-            {
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 1
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 2
-                Paint_DrawPoint(X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 3
-                Paint_DrawPoint(X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 4
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 5
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 6
-                Paint_DrawPoint(X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 7
-                Paint_DrawPoint(X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-            }
-            if (Esp < 0)
-                Esp += 4 * XCurrent + 6;
-            else
+        const UBYTE *Cached = (Index >= 0) ? Paint_GlyphColumns(Font, Index) : NULL;
+        if (Cached)
+        {
+            UWORD ColBytes = (Font->Height + 7) / 8;
+            Cached += C0 * ColBytes;
+            for (UWORD c = C0; c < C1; c++)
             {
-                Esp += 10 + 4 * (XCurrent - YCurrent);
-                YCurrent--;
+                uint32_t Word = 0;
+                for (UWORD b = 0; b < ColBytes; b++)
+                {
+                    Word |= (uint32_t)*Cached++ << (24 - 8 * b);
+                }
+                Lines[c] = Word;
             }
-            XCurrent++;
         }
+        else
+        {
+            uint32_t Glyph[32];
+            Paint_GlyphRows(ptr, Font, Glyph);
+            Paint_TransposeGlyph(Glyph, Font, Lines);
+        }
+        Count = R1 - R0, Skip = R0, First = C0, Last = C1;
+        Across = Ypoint + R0, Down = Xpoint;
     }
     else
-    { // Draw a hollow circle
-        while (XCurrent <= YCurrent)
-        {
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT); // 1
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT); // 2
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT); // 3
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT); // 4
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT); // 5
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT); // 6
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT); // 7
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT); // 0
+    {
+        Paint_GlyphRows(ptr, Font, Lines);
+        Count = C1 - C0, Skip = C0, First = R0, Last = R1;
+        Across = Xpoint + C0, Down = Ypoint;
+    }
 
-            if (Esp < 0)
-                Esp += 4 * XCurrent + 6;
-            else
-            {
-                Esp += 10 + 4 * (XCurrent - YCurrent);
-                YCurrent--;
-            }
-            XCurrent++;
+    uint32_t Keep = (Count >= 32) ? 0xFFFFFFFF : ~(0xFFFFFFFF >> Count);
+    for (UWORD Line = First; Line < Last; Line++)
+    {
+        uint32_t Bits = (Lines[Line] << Skip) & Keep;
+        UWORD X0 = Across;
+        UWORD Y = Down + Line;
+        if (T & PAINT_FLIP_X)
+        {
+            Bits = Paint_Reverse32(Bits) << (32 - Count);
+            X0 = P->WidthMemory - Across - Count;
+        }
+        if (T & PAINT_FLIP_Y)
+        {
+            Y = P->HeightMemory - Y - 1;
         }
+        Paint_BlitRun(P, Y, X0, Bits, Count, Transparent, FgBit, BgBit);
     }
 }
 
@@ -509,54 +2223,93 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
+void Paint_DrawChar_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
+                                  sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    if (Xpoint > P->Width || Ypoint > P->Height)
+    {
+        ESP_LOGW(TAG, "DrawChar at (%d,%d) exceeds display range", Xpoint, Ypoint);
+        return;
+    }
+    Paint_DrawChar_S_Ctx(P, Xpoint, Ypoint, Acsii_Char, Font, Color_Foreground, Color_Background);
+}
+
 void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
                     sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawChar_Ctx(&Paint, Xpoint, Ypoint, Acsii_Char, Font, Color_Foreground, Color_Background);
+}
+
+/******************************************************************************
+function: Show English characters at signed coordinates
+parameter:
+    Xpoint           ：X coordinate
+    Ypoint           ：Y coordinate
+    Acsii_Char       ：To display the English characters
+    Font             ：A structure pointer that displays a character size
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    Only the glyph rows and columns inside the clip rectangle are read.
+******************************************************************************/
+void Paint_DrawChar_S_Ctx(PAINT *P, int Xpoint, int Ypoint, const char Acsii_Char,
+                                    sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
 {
     UWORD Page, Column;
 
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
+    // Visible part of the glyph
+    int C0 = P->Clip.Xstart - Xpoint, C1 = P->Clip.Xend - Xpoint;
+    int R0 = P->Clip.Ystart - Ypoint, R1 = P->Clip.Yend - Ypoint;
+    if (C0 < 0)
+        C0 = 0;
+    if (R0 < 0)
+        R0 = 0;
+    if (C1 > Font->Width)
+        C1 = Font->Width;
+    if (R1 > Font->Height)
+        R1 = Font->Height;
+    if (C0 >= C1 || R0 >= R1)
+        return;
+
+    // Whole font bytes at a time for 1bpp images, a glyph background equal
+    // to FONT_BACKGROUND is left transparent
+    if (P->Scale == 2 && Font->Width <= 32 && Font->Height <= 32)
     {
-        ESP_LOGW(TAG, "DrawChar at (%d,%d) exceeds display range", Xpoint, Ypoint);
+        Paint_BlitGlyph(P, Xpoint, Ypoint, C0, C1, R0, R1, Acsii_Char - ' ', Font,
+                        FONT_BACKGROUND == Color_Background, Color_Foreground, Color_Background);
         return;
     }
 
-    uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
+    UWORD RowBytes = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+    uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * RowBytes;
     const unsigned char *ptr = &Font->table[Char_Offset];
 
-    for (Page = 0; Page < Font->Height; Page++)
+    for (Page = R0; Page < R1; Page++)
     {
-        for (Column = 0; Column < Font->Width; Column++)
+        for (Column = C0; Column < C1; Column++)
         {
+            UBYTE Set = ptr[Page * RowBytes + Column / 8] & (0x80 >> (Column % 8));
 
             // To determine whether the font background color and screen background color is consistent
             if (FONT_BACKGROUND == Color_Background)
             { // this process is to speed up the scan
-                if (*ptr & (0x80 >> (Column % 8)))
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
-                // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+                if (Set)
+                    P->Writer(P, Xpoint + Column, Ypoint + Page, Color_Foreground);
             }
             else
             {
-                if (*ptr & (0x80 >> (Column % 8)))
-                {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
-                    // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                }
-                else
-                {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
-                    // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                }
+                P->Writer(P, Xpoint + Column, Ypoint + Page, Set ? Color_Foreground : Color_Background);
             }
-            // One pixel is 8 bits
-            if (Column % 8 == 7)
-                ptr++;
         } // Write a line
-        if (Font->Width % 8 != 0)
-            ptr++;
     } // Write all
 }
 
+void Paint_DrawChar_S(int Xpoint, int Ypoint, const char Acsii_Char,
+                      sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawChar_S_Ctx(&Paint, Xpoint, Ypoint, Acsii_Char, Font, Color_Foreground, Color_Background);
+}
+
 /******************************************************************************
 function:	Display the string
 parameter:
@@ -567,34 +2320,58 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char *pString,
-                         sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+void Paint_DrawString_EN_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, const char *pString,
+                                       sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
 {
-    UWORD Xpoint = Xstart;
-    UWORD Ypoint = Ystart;
-
-    if (Xstart > Paint.Width || Ystart > Paint.Height)
+    if (Xstart > P->Width || Ystart > P->Height)
     {
         ESP_LOGW(TAG, "DrawString at (%d,%d) exceeds display range", Xstart, Ystart);
         return;
     }
+    Paint_DrawString_S_Ctx(P, Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char *pString,
+                         sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawString_EN_Ctx(&Paint, Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+}
+
+/******************************************************************************
+function:	Display the string at signed coordinates
+parameter:
+    Xstart           ：X coordinate
+    Ystart           ：Y coordinate
+    pString          ：The first address of the English string to be displayed
+    Font             ：A structure pointer that displays a character size
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+info:
+    Lines wrap at the image width as with Paint_DrawString_EN, characters
+    outside the clip rectangle are skipped.
+******************************************************************************/
+void Paint_DrawString_S_Ctx(PAINT *P, int Xstart, int Ystart, const char *pString,
+                                      sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    int Xpoint = Xstart;
+    int Ypoint = Ystart;
 
     while (*pString != '\0')
     {
         // if X direction filled , reposition to(Xstart,Ypoint),Ypoint is Y direction plus the Height of the character
-        if ((Xpoint + Font->Width) > Paint.Width)
+        if ((Xpoint + Font->Width) > P->Width)
         {
             Xpoint = Xstart;
             Ypoint += Font->Height;
         }
 
         // If the Y direction is full, reposition to(Xstart, Ystart)
-        if ((Ypoint + Font->Height) > Paint.Height)
+        if ((Ypoint + Font->Height) > P->Height)
         {
             Xpoint = Xstart;
             Ypoint = Ystart;
         }
-        Paint_DrawChar(Xpoint, Ypoint, *pString, Font, Color_Background, Color_Foreground);
+        Paint_DrawChar_S_Ctx(P, Xpoint, Ypoint, *pString, Font, Color_Background, Color_Foreground);
 
         // The next character of the address
         pString++;
@@ -604,6 +2381,12 @@ void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char *pString,
     }
 }
 
+void Paint_DrawString_S(int Xstart, int Ystart, const char *pString,
+                        sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawString_S_Ctx(&Paint, Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+}
+
 /******************************************************************************
 function: Display the string
 parameter:
@@ -628,15 +2411,15 @@ parameter:
     Color_Background : Select the background color
 ******************************************************************************/
 #define ARRAY_LEN 255
-void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
-                   sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+void Paint_DrawNum_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
+                                 sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
 {
 
     int16_t Num_Bit = 0, Str_Bit = 0;
     uint8_t Str_Array[ARRAY_LEN] = {0}, Num_Array[ARRAY_LEN] = {0};
     uint8_t *pStr = Str_Array;
 
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
+    if (Xpoint > P->Width || Ypoint > P->Height)
     {
         ESP_LOGW(TAG, "DrawNum at (%d,%d) exceeds display range", Xpoint, Ypoint);
         return;
@@ -659,7 +2442,13 @@ void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
     }
 
     // show
-    Paint_DrawString_EN(Xpoint, Ypoint, (const char *)pStr, Font, Color_Background, Color_Foreground);
+    Paint_DrawString_EN_Ctx(P, Xpoint, Ypoint, (const char *)pStr, Font, Color_Background, Color_Foreground);
+}
+
+void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
+                   sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawNum_Ctx(&Paint, Xpoint, Ypoint, Nummber, Font, Color_Foreground, Color_Background);
 }
 
 /******************************************************************************
@@ -672,22 +2461,28 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT *Font,
-                    UWORD Color_Foreground, UWORD Color_Background)
+void Paint_DrawTime_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT *Font,
+                                  UWORD Color_Foreground, UWORD Color_Background)
 {
     uint8_t value[10] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
 
     UWORD Dx = Font->Width;
 
     // Write data into the cache
-    Paint_DrawChar(Xstart, Ystart, value[pTime->Hour / 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx, Ystart, value[pTime->Hour % 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx + Dx / 4 + Dx / 2, Ystart, ':', Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 2 + Dx / 2, Ystart, value[pTime->Min / 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 3 + Dx / 2, Ystart, value[pTime->Min % 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 4 + Dx / 2 - Dx / 4, Ystart, ':', Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 5, Ystart, value[pTime->Sec / 10], Font, Color_Background, Color_Foreground);
-    Paint_DrawChar(Xstart + Dx * 6, Ystart, value[pTime->Sec % 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart, Ystart, value[pTime->Hour / 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx, Ystart, value[pTime->Hour % 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx + Dx / 4 + Dx / 2, Ystart, ':', Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx * 2 + Dx / 2, Ystart, value[pTime->Min / 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx * 3 + Dx / 2, Ystart, value[pTime->Min % 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx * 4 + Dx / 2 - Dx / 4, Ystart, ':', Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx * 5, Ystart, value[pTime->Sec / 10], Font, Color_Background, Color_Foreground);
+    Paint_DrawChar_Ctx(P, Xstart + Dx * 6, Ystart, value[pTime->Sec % 10], Font, Color_Background, Color_Foreground);
+}
+
+void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT *Font,
+                    UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_DrawTime_Ctx(&Paint, Xstart, Ystart, pTime, Font, Color_Foreground, Color_Background);
 }
 
 /******************************************************************************
@@ -697,18 +2492,273 @@ parameter:
 info:
     Use a computer to convert the image into a corresponding array,
     and then embed the array directly into Imagedata.cpp as a .c file.
+    The bitmap has the layout of the image buffer, only the part inside
+    the clip rectangle is copied.
 ******************************************************************************/
+void Paint_DrawBitMap_Ctx(PAINT *P, const unsigned char *image_buffer)
+{
+    int Xstart = P->Clip.Xstart, Ystart = P->Clip.Ystart;
+    int Xend = P->Clip.Xend - 1, Yend = P->Clip.Yend - 1;
+    UWORD X0, Y0, X1, Y1;
+
+    if (Xstart == 0 && Ystart == 0 && Xend == P->Width - 1 && Yend == P->Height - 1)
+    {
+        Frame_Copy(P->Image, image_buffer, (UDOUBLE)P->WidthByte * P->HeightByte);
+        return;
+    }
+    if (Xstart > Xend || Ystart > Yend)
+        return;
+
+    Paint_MapRect(P, Xstart, Ystart, Xend, Yend, &X0, &Y0, &X1, &Y1);
+    Paint_CopyMemRect(P, image_buffer, X0, Y0, X1, Y1);
+}
+
 void Paint_DrawBitMap(const unsigned char *image_buffer)
 {
-    UWORD x, y;
-    UDOUBLE Addr = 0;
+    Paint_DrawBitMap_Ctx(&Paint, image_buffer);
+}
+
+/******************************************************************************
+function: Combine source bits into one image byte
+parameter:
+    D   : Image byte
+    V   : Source bits lined up with D
+    M   : Bits of D that may change
+    Rop : Raster operation, a PAINT_ROP_MASK mask is already part of M
+******************************************************************************/
+static inline UBYTE Paint_Rop(UBYTE D, UBYTE V, UBYTE M, PAINT_ROP Rop)
+{
+    switch (Rop)
+    {
+    case PAINT_ROP_OR:
+        return D | (V & M);
+    case PAINT_ROP_AND:
+        return D & (V | ~M);
+    case PAINT_ROP_XOR:
+        return D ^ (V & M);
+    default:
+        return (D & ~M) | (V & M);
+    }
+}
+
+/******************************************************************************
+function: Read 8 source bits starting Shift bits into byte I
+parameter:
+    S     : Source bytes
+    I     : Byte index, may be -1
+    Shift : Bit offset into byte I
+    Last  : Last byte index that may be read
+******************************************************************************/
+static inline UBYTE Paint_RopFetch(const UBYTE *S, int I, UBYTE Shift, int Last)
+{
+    UBYTE V = (I >= 0) ? (UBYTE)(S[I] << Shift) : 0;
+    if (Shift && I + 1 <= Last)
+        V |= S[I + 1] >> (8 - Shift);
+    return V;
+}
+
+/******************************************************************************
+function: Apply a run of source bits to one image row
+parameter:
+    Row    : Image row
+    MX     : Image column of the first bit
+    Src    : Source bits, MSB first
+    Mask   : Mask bits laid out like Src, NULL unless PAINT_ROP_MASK
+    SrcBit : Bit of Src where the run starts
+    Count  : Number of bits
+    Rop    : Raster operation
+info:
+    Each image byte is built from at most two source bytes shifted into
+    place, so an unaligned run costs the same as an aligned one. Only the
+    first and last image byte are masked.
+******************************************************************************/
+static void Paint_RopSpan(UBYTE *Row, UWORD MX, const UBYTE *Src, const UBYTE *Mask,
+                          UDOUBLE SrcBit, UWORD Count, PAINT_ROP Rop)
+{
+    Src += SrcBit / 8;
+    if (Mask)
+        Mask += SrcBit / 8;
+    int D = (int)(SrcBit % 8) - MX % 8;
+    int Lo = (D < 0) ? -1 : 0;
+    UBYTE Shift = D & 7;
+    int Last = (int)(SrcBit % 8 + Count - 1) / 8;
+
+    UWORD First = MX / 8, N = (MX + Count - 1) / 8 - First;
+    Row += First;
+    UBYTE HeadMask = 0xFF >> (MX % 8);
+    UBYTE TailMask = 0xFF << (7 - (MX + Count - 1) % 8);
+
+    // Head and tail may read past the run, guard them
+    UBYTE M = HeadMask & ((N == 0) ? TailMask : 0xFF);
+    if (Mask)
+        M &= Paint_RopFetch(Mask, Lo, Shift, Last);
+    Row[0] = Paint_Rop(Row[0], Paint_RopFetch(Src, Lo, Shift, Last), M, Rop);
+    if (N == 0)
+        return;
+
+    if (Shift == 0 && Mask == NULL && Rop == PAINT_ROP_COPY)
+    {
+        memcpy(&Row[1], &Src[1 + Lo], N - 1);
+    }
+    else
+    {
+        for (UWORD R = 1; R < N; R++)
+        {
+            int I = R + Lo;
+            UBYTE V = Shift ? (UBYTE)((Src[I] << Shift) | (Src[I + 1] >> (8 - Shift))) : Src[I];
+            M = 0xFF;
+            if (Mask)
+                M = Shift ? (UBYTE)((Mask[I] << Shift) | (Mask[I + 1] >> (8 - Shift))) : Mask[I];
+            Row[R] = Paint_Rop(Row[R], V, M, Rop);
+        }
+    }
+
+    M = TailMask;
+    if (Mask)
+        M &= Paint_RopFetch(Mask, N + Lo, Shift, Last);
+    Row[N] = Paint_Rop(Row[N], Paint_RopFetch(Src, N + Lo, Shift, Last), M, Rop);
+}
+
+/******************************************************************************
+function: Apply a run of source bits to one image row, optionally reversed
+parameter:
+    Row     : Image row
+    MX      : Image column of the leftmost bit written
+    Reverse : Bit k of the run goes to MX + Count - 1 - k instead of MX + k
+    Src, Mask, SrcBit, Count, Rop : As for Paint_RopSpan
+info:
+    A reversed run is bit-reversed PAINT_BLIT_CHUNK bits at a time into a
+    buffer on the stack first.
+******************************************************************************/
+#define PAINT_BLIT_CHUNK 256
+static void Paint_RopBits(UBYTE *Row, UWORD MX, UBYTE Reverse, const UBYTE *Src, const UBYTE *Mask,
+                          UDOUBLE SrcBit, UWORD Count, PAINT_ROP Rop)
+{
+    if (!Reverse)
+    {
+        Paint_RopSpan(Row, MX, Src, Mask, SrcBit, Count, Rop);
+        return;
+    }
+
+    UBYTE Rev[PAINT_BLIT_CHUNK / 8 + 1], RevMask[PAINT_BLIT_CHUNK / 8 + 1];
+    for (UWORD K = 0; K < Count; K += PAINT_BLIT_CHUNK)
+    {
+        UWORD N = (Count - K < PAINT_BLIT_CHUNK) ? Count - K : PAINT_BLIT_CHUNK;
+        UDOUBLE B = SrcBit + K;
+        UDOUBLE B0 = B / 8, B1 = (B + N - 1) / 8;
+        for (UDOUBLE j = 0; j <= B1 - B0; j++)
+        {
+            Rev[j] = (UBYTE)(Paint_Reverse32(Src[B1 - j]) >> 24);
+            if (Mask)
+                RevMask[j] = (UBYTE)(Paint_Reverse32(Mask[B1 - j]) >> 24);
+        }
+        // Bit s of Src is now bit 8 * B1 + 7 - s of Rev
+        Paint_RopSpan(Row, MX + Count - K - N, Rev, Mask ? RevMask : NULL,
+                      8 * B1 + 7 - (B + N - 1), N, Rop);
+    }
+}
+
+/******************************************************************************
+function: Draw a 1bpp bitmap with a raster operation
+parameter:
+    Xpoint, Ypoint : Position of the top-left bitmap pixel, may be negative
+    Width, Height  : Bitmap size in pixels
+    Src            : Bitmap rows, MSB first, 1 is white as in the image
+    Stride         : Bytes per bitmap row, 0 for (Width + 7) / 8
+    Rop            : Raster operation
+info:
+    PAINT_ROP_COPY replaces the pixels, PAINT_ROP_OR draws only the white
+    ones, PAINT_ROP_AND only the black ones and PAINT_ROP_XOR inverts where
+    the bitmap is white. PAINT_ROP_MASK expects a mask of the same size
+    after the bitmap, Height more rows of Stride bytes: where it is 1 the
+    bitmap is copied, elsewhere the image is left as it is.
+    Only the part inside the clip rectangle is drawn. Without an X/Y swap
+    bitmap rows go to image rows as shifted bytes, reversed when X is
+    flipped. With a swap bitmap columns become image rows, gathered
+    8 x 8 pixels at a time. Needs a 1bpp image.
+******************************************************************************/
+void Paint_Blit_Ctx(PAINT *P, int Xpoint, int Ypoint, UWORD Width, UWORD Height,
+                              const UBYTE *Src, UWORD Stride, PAINT_ROP Rop)
+{
+    if (Src == NULL || Width == 0 || Height == 0)
+        return;
+    if (P->Scale != 2)
+    {
+        ESP_LOGW(TAG, "Paint_Blit needs a 1bpp image, scale is %d", P->Scale);
+        return;
+    }
+    if (Stride == 0)
+        Stride = (Width + 7) / 8;
+
+    int Xstart = Xpoint, Ystart = Ypoint;
+    int Xend = Xpoint + Width - 1, Yend = Ypoint + Height - 1;
+    if (!Paint_ClipRect(P, &Xstart, &Ystart, &Xend, &Yend))
+        return;
+    UWORD X0, Y0, X1, Y1;
+    Paint_MapRect(P, Xstart, Ystart, Xend, Yend, &X0, &Y0, &X1, &Y1);
+
+    UBYTE T = Paint_Transform(P);
+    const UBYTE *Mask = (Rop == PAINT_ROP_MASK) ? Src + (UDOUBLE)Stride * Height : NULL;
+    UWORD I0 = Xstart - Xpoint, J0 = Ystart - Ypoint;
+    UWORD W = Xend - Xstart + 1, H = Yend - Ystart + 1;
+
+    if (!(T & PAINT_SWAP))
+    {
+        for (UWORD j = 0; j < H; j++)
+        {
+            UWORD MY = (T & PAINT_FLIP_Y) ? Y1 - j : Y0 + j;
+            UDOUBLE Offset = (UDOUBLE)(J0 + j) * Stride;
+            Paint_RopBits(PAINT_ROW(P, MY), X0, T & PAINT_FLIP_X,
+                          Src + Offset, Mask ? Mask + Offset : NULL, I0, W, Rop);
+        }
+        return;
+    }
 
-    for (y = 0; y < Paint.HeightByte; y++)
+    // Bitmap column i becomes image row Y0 + i, read 8 columns at a time
+    UBYTE Cols[8][PAINT_BLIT_CHUNK / 8], MaskCols[8][PAINT_BLIT_CHUNK / 8];
+    for (UWORD J = 0; J < H; J += PAINT_BLIT_CHUNK)
     {
-        for (x = 0; x < Paint.WidthByte; x++)
-        { // 8 pixel =  1 byte
-            Addr = x + y * Paint.WidthByte;
-            Paint.Image[Addr] = (unsigned char)image_buffer[Addr];
+        UWORD N = (H - J < PAINT_BLIT_CHUNK) ? H - J : PAINT_BLIT_CHUNK;
+        UWORD MX = (T & PAINT_FLIP_X) ? X1 - J - N + 1 : X0 + J;
+
+        for (UWORD C = I0 / 8; C <= (I0 + W - 1) / 8; C++)
+        {
+            for (UWORD Page = 0; Page < N; Page += 8)
+            {
+                uint64_t Block = 0, MaskBlock = 0;
+                for (UWORD k = 0; k < 8; k++)
+                {
+                    UDOUBLE Offset = (UDOUBLE)(J0 + J + Page + k) * Stride + C;
+                    UBYTE In = (Page + k < N) ? Src[Offset] : 0;
+                    Block = (Block << 8) | In;
+                    if (Mask)
+                        MaskBlock = (MaskBlock << 8) | ((Page + k < N) ? Mask[Offset] : 0);
+                }
+                Block = Frame_Transpose8x8(Block);
+                if (Mask)
+                    MaskBlock = Frame_Transpose8x8(MaskBlock);
+                for (UWORD k = 0; k < 8; k++)
+                {
+                    Cols[k][Page / 8] = (UBYTE)(Block >> (56 - 8 * k));
+                    MaskCols[k][Page / 8] = (UBYTE)(MaskBlock >> (56 - 8 * k));
+                }
+            }
+
+            for (UWORD k = 0; k < 8; k++)
+            {
+                int i = 8 * C + k;
+                if (i < I0 || i >= I0 + W)
+                    continue;
+                UWORD MY = (T & PAINT_FLIP_Y) ? Y1 - (i - I0) : Y0 + (i - I0);
+                Paint_RopBits(PAINT_ROW(P, MY), MX, T & PAINT_FLIP_X,
+                              Cols[k], Mask ? MaskCols[k] : NULL, 0, N, Rop);
+            }
         }
     }
 }
+
+void Paint_Blit(int Xpoint, int Ypoint, UWORD Width, UWORD Height,
+                const UBYTE *Src, UWORD Stride, PAINT_ROP Rop)
+{
+    Paint_Blit_Ctx(&Paint, Xpoint, Ypoint, Width, Height, Src, Stride, Rop);
+}
@@ -0,0 +1,866 @@
+/**
+ * @file benchmark_example.c
+ * @brief Performance benchmark for ESP32 E-Paper Display Library
+ *
+ * This example measures:
+ * - Frame upload time with the legacy per-byte SPI path
+ * - Frame upload time with the bulk DMA path used by the driver
+ * - BUSY time of the OTP partial refresh and of each host-loaded LUT profile
+ * - Plane split and upload time of a 4-level grayscale frame
+ * - Full-screen filled rectangle: per-pixel rows vs span fill
+ * - Paint_SetPixel throughput for every rotation, mirror and scale
+ * - Font24 glyphs per second: per-pixel rendering vs the glyph blitter
+ * - Circles: pixel writes and time of per-point stamping vs scanline spans
+ * - A plot of thick lines: square brush per Bresenham step vs row spans
+ * - Polygons: per-pixel inside test over the bounding box vs the edge table,
+ *   plus rounded rectangles and arcs
+ * - A screen of 24x24 icons: per-pixel SetPixel vs Paint_Blit, per rotation
+ * - Frame kernels: bytes/s of byte loops vs the 32-bit Frame_Ops kernels
+ * - A landscape screen drawn with ROTATE_90 vs a landscape buffer plus the
+ *   transpose to panel order
+ * - The same screen from a display list, rendered band by band: time and
+ *   peak RAM against a full frame buffer
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "DEV_Config.h"
+#include "EPD_2in13.h"
+#include "GUI_Paint.h"
+#include "Frame_Ops.h"
+#include "GUI_DisplayList.h"
+#include "fonts.h"
+
+static const char *TAG = "EPD_BENCH";
+
+// Buffer size calculation must match Paint library's WidthByte calculation
+#define WIDTHBYTE(width) (((width) % 8 == 0) ? ((width) / 8) : ((width) / 8 + 1))
+#define IMAGE_SIZE (WIDTHBYTE(EPD_2IN13_WIDTH) * EPD_2IN13_HEIGHT)
+#define GRAY_IMAGE_SIZE ((((EPD_2IN13_WIDTH) + 3) / 4) * EPD_2IN13_HEIGHT)
+
+#define BENCH_ROUNDS 5
+#define BENCH_PIXELS 100000
+#define BENCH_GLYPHS 500
+#define BENCH_PLOT_POINTS 60
+#define BENCH_ICON 24
+#define BENCH_FRAME_ROUNDS 200
+#define BENCH_BAND_ROWS 16
+
+/**
+ * Upload a frame the way the driver used to: one SPI transaction per byte,
+ * with DC and CS toggled around each of them.
+ */
+static int64_t bench_upload_per_byte(const UBYTE *image)
+{
+    int64_t start = esp_timer_get_time();
+
+    DEV_Digital_Write(EPD_DC_PIN, 0);
+    DEV_Digital_Write(EPD_CS_PIN, 0);
+    DEV_SPI_WriteByte(0x24);
+    DEV_Digital_Write(EPD_CS_PIN, 1);
+
+    for (int i = 0; i < IMAGE_SIZE; i++) {
+        DEV_Digital_Write(EPD_DC_PIN, 1);
+        DEV_Digital_Write(EPD_CS_PIN, 0);
+        DEV_SPI_WriteByte(image[i]);
+        DEV_Digital_Write(EPD_CS_PIN, 1);
+    }
+
+    return esp_timer_get_time() - start;
+}
+
+/**
+ * Fill the screen the way a filled rectangle used to be drawn: one line
+ * per row, each stepped a pixel at a time through Paint_SetPixel.
+ * Paint_DrawLine fills rows as spans now, so the old path is spelled out.
+ */
+static int64_t bench_fill_per_line(UWORD color)
+{
+    int64_t start = esp_timer_get_time();
+    for (UWORD y = 1; y < Paint.Height; y++) {
+        for (UWORD x = 1; x < Paint.Width; x++) {
+            Paint_SetPixel(x, y, color);
+        }
+    }
+    return esp_timer_get_time() - start;
+}
+
+static int64_t bench_fill_span(UWORD color)
+{
+    int64_t start = esp_timer_get_time();
+    Paint_DrawRectangle(1, 1, Paint.Width, Paint.Height, color, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    return esp_timer_get_time() - start;
+}
+
+/**
+ * Pixels per second through the writer Paint picks for each
+ * rotation x mirror x scale combination.
+ */
+static void bench_pixel_writers(void)
+{
+    static const UWORD rotations[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+    static const UBYTE scales[] = {2, 4, 7};
+
+    // Scale 7 packs 2 pixels per byte, the largest buffer
+    UBYTE *buf = (UBYTE *)malloc(((EPD_2IN13_WIDTH + 1) / 2) * EPD_2IN13_HEIGHT);
+    if (buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate pixel benchmark buffer");
+        return;
+    }
+
+    ESP_LOGI(TAG, "Paint_SetPixel throughput:");
+    for (size_t s = 0; s < sizeof(scales); s++) {
+        for (size_t r = 0; r < sizeof(rotations) / sizeof(rotations[0]); r++) {
+            for (UBYTE m = MIRROR_NONE; m <= MIRROR_ORIGIN; m++) {
+                Paint_NewImage(buf, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, rotations[r], WHITE);
+                Paint_SetScale(scales[s]);
+                Paint_SetMirroring(m);
+
+                int64_t start = esp_timer_get_time();
+                for (UDOUBLE i = 0; i < BENCH_PIXELS; i++) {
+                    Paint_SetPixel(i % Paint.Width, (i / Paint.Width) % Paint.Height, (i & 1) ? WHITE : BLACK);
+                }
+                int64_t us = esp_timer_get_time() - start;
+                ESP_LOGI(TAG, "  scale %d rotate %3d mirror %d: %lu kpixels/s", scales[s], rotations[r], m,
+                         (unsigned long)(us > 0 ? (int64_t)BENCH_PIXELS * 1000 / us : 0));
+            }
+        }
+    }
+    free(buf);
+}
+
+/**
+ * Draw a character the way Paint_DrawChar used to: one SetPixel per
+ * glyph bit.
+ */
+static void draw_char_per_pixel(UWORD x, UWORD y, char c, sFONT *font, UWORD fg, UWORD bg)
+{
+    UWORD row_bytes = font->Width / 8 + (font->Width % 8 ? 1 : 0);
+    const uint8_t *ptr = &font->table[(c - ' ') * font->Height * row_bytes];
+
+    for (UWORD page = 0; page < font->Height; page++) {
+        for (UWORD column = 0; column < font->Width; column++) {
+            if (ptr[page * row_bytes + column / 8] & (0x80 >> (column % 8))) {
+                Paint_SetPixel(x + column, y + page, fg);
+            } else {
+                Paint_SetPixel(x + column, y + page, bg);
+            }
+        }
+    }
+}
+
+static void bench_glyphs(void)
+{
+    static const UWORD rotations[] = {ROTATE_0, ROTATE_90};
+
+    ESP_LOGI(TAG, "Font24 glyphs, opaque:");
+    for (size_t r = 0; r < sizeof(rotations) / sizeof(rotations[0]); r++) {
+        Paint_SetRotate(rotations[r]);
+        UWORD cols = Paint.Width / Font24.Width, rows = Paint.Height / Font24.Height;
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < BENCH_GLYPHS; i++) {
+            draw_char_per_pixel((i % cols) * Font24.Width, (i / cols % rows) * Font24.Height,
+                                'A' + i % 26, &Font24, WHITE, BLACK);
+        }
+        int64_t pixel_us = esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < BENCH_GLYPHS; i++) {
+            Paint_DrawChar((i % cols) * Font24.Width, (i / cols % rows) * Font24.Height,
+                           'A' + i % 26, &Font24, WHITE, BLACK);
+        }
+        int64_t blit_us = esp_timer_get_time() - start;
+
+        ESP_LOGI(TAG, "  rotate %3d: per-pixel %lu glyphs/s, blitter %lu glyphs/s", rotations[r],
+                 (unsigned long)(pixel_us > 0 ? (int64_t)BENCH_GLYPHS * 1000000 / pixel_us : 0),
+                 (unsigned long)(blit_us > 0 ? (int64_t)BENCH_GLYPHS * 1000000 / blit_us : 0));
+    }
+
+    // Landscape text from the pre-rotated glyph cache, built on the first glyph
+    Paint_SetRotate(ROTATE_90);
+    UWORD cols = Paint.Width / Font24.Width, rows = Paint.Height / Font24.Height;
+    Paint_SetGlyphCache(1);
+    int64_t start = esp_timer_get_time();
+    Paint_DrawChar(0, 0, 'A', &Font24, WHITE, BLACK);
+    int64_t build_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_GLYPHS; i++) {
+        Paint_DrawChar((i % cols) * Font24.Width, (i / cols % rows) * Font24.Height,
+                       'A' + i % 26, &Font24, WHITE, BLACK);
+    }
+    int64_t cached_us = esp_timer_get_time() - start;
+    Paint_SetGlyphCache(0);
+
+    ESP_LOGI(TAG, "  rotate  90: glyph cache %lu glyphs/s, built in %lu us",
+             (unsigned long)(cached_us > 0 ? (int64_t)BENCH_GLYPHS * 1000000 / cached_us : 0),
+             (unsigned long)build_us);
+}
+
+/**
+ * Draw a circle the way Paint_DrawCircle used to: eight points for every
+ * midpoint step, each a (2 * width - 1) square of SetPixel calls. Returns
+ * the number of pixel writes.
+ */
+static UDOUBLE draw_circle_per_point(int xc, int yc, int radius, UWORD color, int width, DRAW_FILL fill)
+{
+    UDOUBLE writes = 0;
+    int x = 0, y = radius, esp = 3 - (radius << 1);
+
+    while (x <= y) {
+        int lo = fill ? x : y;
+        for (int s = lo; s <= y; s++) {
+            const int pts[8][2] = {{x, s}, {-x, s}, {-s, x}, {-s, -x}, {-x, -s}, {x, -s}, {s, -x}, {s, x}};
+            int w = fill ? 1 : width;
+            for (int p = 0; p < 8; p++) {
+                for (int dx = -w; dx <= w - 2; dx++) {
+                    for (int dy = -w; dy <= w - 2; dy++) {
+                        Paint_SetPixel_S(xc + pts[p][0] + dx, yc + pts[p][1] + dy, color);
+                        writes++;
+                    }
+                }
+            }
+        }
+        if (esp < 0) {
+            esp += 4 * x + 6;
+        } else {
+            esp += 10 + 4 * (x - y);
+            y--;
+        }
+        x++;
+    }
+    return writes;
+}
+
+// Pixels drawn black on a white image, each span pixel is written once
+static UDOUBLE count_black(const UBYTE *image)
+{
+    return IMAGE_SIZE * 8 - Frame_Popcount(image, IMAGE_SIZE);
+}
+
+static void bench_circles(UBYTE *image)
+{
+    static const struct {
+        int radius;
+        DOT_PIXEL width;
+        DRAW_FILL fill;
+        const char *name;
+    } cases[] = {
+        {55, DOT_PIXEL_1X1, DRAW_FILL_FULL, "filled r=55     "},
+        {55, DOT_PIXEL_4X4, DRAW_FILL_EMPTY, "outline r=55 w=4"},
+    };
+
+    Paint_SetRotate(ROTATE_0);
+    ESP_LOGI(TAG, "Circles:");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        Paint_Clear(WHITE);
+        int64_t start = esp_timer_get_time();
+        UDOUBLE old_writes = draw_circle_per_point(61, 125, cases[c].radius, BLACK, cases[c].width, cases[c].fill);
+        int64_t old_us = esp_timer_get_time() - start;
+
+        Paint_Clear(WHITE);
+        start = esp_timer_get_time();
+        Paint_DrawCircle(61, 125, cases[c].radius, BLACK, cases[c].width, cases[c].fill);
+        int64_t new_us = esp_timer_get_time() - start;
+
+        ESP_LOGI(TAG, "  %s: per-point %lu writes %lu us, spans %lu writes %lu us", cases[c].name,
+                 (unsigned long)old_writes, (unsigned long)old_us,
+                 (unsigned long)count_black(image), (unsigned long)new_us);
+    }
+
+    Paint_Clear(WHITE);
+    int64_t start = esp_timer_get_time();
+    Paint_DrawEllipse(61, 125, 55, 100, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    ESP_LOGI(TAG, "  filled ellipse 55x100: %lu writes %lu us", (unsigned long)count_black(image),
+             (unsigned long)(esp_timer_get_time() - start));
+}
+
+/**
+ * Draw a line the way a thick Paint_DrawLine used to: a square brush of
+ * (2 * width - 1)^2 pixels at every Bresenham step. Returns the number of
+ * pixel writes.
+ */
+static UDOUBLE draw_line_stamped(int x0, int y0, int x1, int y1, UWORD color, int width)
+{
+    UDOUBLE writes = 0;
+    int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    for (;;) {
+        for (int bx = -width; bx <= width - 2; bx++) {
+            for (int by = -width; by <= width - 2; by++) {
+                Paint_SetPixel_S(x0 + bx, y0 + by, color);
+                writes++;
+            }
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            if (x0 == x1) {
+                break;
+            }
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            if (y0 == y1) {
+                break;
+            }
+            err += dx;
+            y0 += sy;
+        }
+    }
+    return writes;
+}
+
+/**
+ * A line chart in landscape: a grid and three 3-pixel traces of
+ * BENCH_PLOT_POINTS points each.
+ */
+static void bench_plot(UBYTE *image)
+{
+    static const DOT_PIXEL widths[] = {DOT_PIXEL_2X2, DOT_PIXEL_3X3};
+
+    Paint_SetRotate(ROTATE_90);
+    ESP_LOGI(TAG, "Plot, %d segments per trace:", BENCH_PLOT_POINTS - 1);
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        UDOUBLE old_writes = 0;
+        int64_t old_us = 0, new_us = 0;
+
+        for (int pass = 0; pass < 2; pass++) {
+            Paint_Clear(WHITE);
+            int64_t start = esp_timer_get_time();
+            for (int gx = 10; gx < Paint.Width; gx += 40) {
+                if (pass) {
+                    Paint_DrawLine(gx, 5, gx, Paint.Height - 5, BLACK, widths[w], LINE_STYLE_SOLID);
+                } else {
+                    old_writes += draw_line_stamped(gx, 5, gx, Paint.Height - 5, BLACK, widths[w]);
+                }
+            }
+            for (int trace = 0; trace < 3; trace++) {
+                int px = 10, py = 60;
+                for (int i = 1; i < BENCH_PLOT_POINTS; i++) {
+                    int x = 10 + i * (Paint.Width - 20) / (BENCH_PLOT_POINTS - 1);
+                    int y = 60 + ((i * 37 + trace * 53) % 90) - 45;
+                    if (pass) {
+                        Paint_DrawLine(px, py, x, y, BLACK, widths[w], LINE_STYLE_SOLID);
+                    } else {
+                        old_writes += draw_line_stamped(px, py, x, y, BLACK, widths[w]);
+                    }
+                    px = x, py = y;
+                }
+            }
+            if (pass) {
+                new_us = esp_timer_get_time() - start;
+            } else {
+                old_us = esp_timer_get_time() - start;
+            }
+        }
+
+        ESP_LOGI(TAG, "  width %d: stamped %lu writes %lu us, spans %lu pixels %lu us", widths[w],
+                 (unsigned long)old_writes, (unsigned long)old_us,
+                 (unsigned long)count_black(image), (unsigned long)new_us);
+    }
+}
+
+/**
+ * Fill a polygon by testing every pixel of its bounding box against all
+ * edges, even-odd rule. Returns the number of pixels tested.
+ */
+static UDOUBLE fill_polygon_per_pixel(const PAINT_POINT *pts, int n, UWORD color)
+{
+    int x0 = pts[0].X, x1 = pts[0].X, y0 = pts[0].Y, y1 = pts[0].Y;
+    for (int i = 1; i < n; i++) {
+        x0 = pts[i].X < x0 ? pts[i].X : x0;
+        x1 = pts[i].X > x1 ? pts[i].X : x1;
+        y0 = pts[i].Y < y0 ? pts[i].Y : y0;
+        y1 = pts[i].Y > y1 ? pts[i].Y : y1;
+    }
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int in = 0;
+            for (int i = 0, j = n - 1; i < n; j = i++) {
+                if ((pts[i].Y > y) != (pts[j].Y > y) &&
+                    x < pts[j].X + (float)(pts[i].X - pts[j].X) * (y - pts[j].Y) / (pts[i].Y - pts[j].Y)) {
+                    in = !in;
+                }
+            }
+            if (in) {
+                Paint_SetPixel_S(x - 1, y - 1, color);
+            }
+        }
+    }
+    return (UDOUBLE)(x1 - x0 + 1) * (y1 - y0 + 1);
+}
+
+static void bench_shapes(UBYTE *image)
+{
+    // An 8-tip star across the landscape screen
+    PAINT_POINT star[16];
+    for (int i = 0; i < 16; i++) {
+        float a = i * (float)M_PI / 8;
+        int r = (i % 2) ? 18 : 58;
+        star[i].X = 125 + (int)(2 * r * cosf(a));
+        star[i].Y = 61 + (int)(r * sinf(a));
+    }
+
+    Paint_SetRotate(ROTATE_90);
+    ESP_LOGI(TAG, "Polygons:");
+    Paint_Clear(WHITE);
+    int64_t start = esp_timer_get_time();
+    UDOUBLE tested = fill_polygon_per_pixel(star, 16, BLACK);
+    int64_t old_us = esp_timer_get_time() - start;
+    UDOUBLE filled = count_black(image);
+
+    Paint_Clear(WHITE);
+    start = esp_timer_get_time();
+    Paint_FillPolygon(star, 16, BLACK);
+    int64_t new_us = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "  16-point star: per-pixel %lu tested %lu filled %lu us, edge table %lu filled %lu us",
+             (unsigned long)tested, (unsigned long)filled, (unsigned long)old_us,
+             (unsigned long)count_black(image), (unsigned long)new_us);
+
+    // A dashboard: rounded buttons and a thick gauge arc
+    Paint_Clear(WHITE);
+    start = esp_timer_get_time();
+    for (int b = 0; b < 4; b++) {
+        Paint_DrawRoundRect(6 + b * 61, 84, 60 + b * 61, 116, 8, BLACK, DOT_PIXEL_2X2,
+                            b % 2 ? DRAW_FILL_FULL : DRAW_FILL_EMPTY);
+    }
+    Paint_DrawArc(125, 75, 60, 150, 390, BLACK, DOT_PIXEL_4X4);
+    Paint_FillTriangle(125, 75, 170, 30, 132, 82, BLACK);
+    ESP_LOGI(TAG, "  dashboard: %lu pixels %lu us", (unsigned long)count_black(image),
+             (unsigned long)(esp_timer_get_time() - start));
+}
+
+/**
+ * Fill the screen with 24x24 icons, drawn pixel by pixel and with
+ * Paint_Blit, for portrait and landscape.
+ */
+static void bench_icons(void)
+{
+    static UBYTE icon[BENCH_ICON * BENCH_ICON / 8 * 2];
+    const int stride = BENCH_ICON / 8;
+
+    // A ring with its mask, stored after the bitmap for PAINT_ROP_MASK
+    for (int y = 0; y < BENCH_ICON; y++) {
+        for (int x = 0; x < BENCH_ICON; x++) {
+            int dx = 2 * x - BENCH_ICON + 1, dy = 2 * y - BENCH_ICON + 1, d = dx * dx + dy * dy;
+            UBYTE bit = 0x80 >> (x % 8);
+            if (d > 14 * 14 && d < 22 * 22) {
+                icon[y * stride + x / 8] &= ~bit;
+            } else {
+                icon[y * stride + x / 8] |= bit;
+            }
+            if (d < 22 * 22) {
+                icon[(BENCH_ICON + y) * stride + x / 8] |= bit;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "Icons, %dx%d at unaligned X:", BENCH_ICON, BENCH_ICON);
+    static const UWORD rotations[] = {ROTATE_0, ROTATE_90};
+    for (size_t r = 0; r < sizeof(rotations) / sizeof(rotations[0]); r++) {
+        Paint_SetRotate(rotations[r]);
+        int count = 0;
+        int64_t pixel_us = 0, blit_us = 0, mask_us = 0;
+
+        for (int pass = 0; pass < 3; pass++) {
+            Paint_Clear(WHITE);
+            int64_t start = esp_timer_get_time();
+            count = 0;
+            for (int y = 3; y + BENCH_ICON <= Paint.Height; y += BENCH_ICON + 1) {
+                for (int x = 5; x + BENCH_ICON <= Paint.Width; x += BENCH_ICON + 1) {
+                    if (pass == 0) {
+                        for (int j = 0; j < BENCH_ICON; j++) {
+                            for (int i = 0; i < BENCH_ICON; i++) {
+                                if (!(icon[j * stride + i / 8] & (0x80 >> (i % 8)))) {
+                                    Paint_SetPixel(x + i, y + j, BLACK);
+                                }
+                            }
+                        }
+                    } else {
+                        Paint_Blit(x, y, BENCH_ICON, BENCH_ICON, icon, stride,
+                                   pass == 1 ? PAINT_ROP_AND : PAINT_ROP_MASK);
+                    }
+                    count++;
+                }
+            }
+            int64_t us = esp_timer_get_time() - start;
+            if (pass == 0) {
+                pixel_us = us;
+            } else if (pass == 1) {
+                blit_us = us;
+            } else {
+                mask_us = us;
+            }
+        }
+        ESP_LOGI(TAG, "  rotate %3d, %d icons: per-pixel %lu us, blit AND %lu us, blit MASK %lu us",
+                 rotations[r], count, (unsigned long)pixel_us, (unsigned long)blit_us, (unsigned long)mask_us);
+    }
+}
+
+/**
+ * Whole-buffer operations as byte loops, the way Paint_Clear and
+ * Paint_DrawBitMap walked the image, against the Frame_Ops kernels.
+ */
+static UDOUBLE bench_frame_rate(int64_t us)
+{
+    return us > 0 ? (UDOUBLE)((int64_t)IMAGE_SIZE * BENCH_FRAME_ROUNDS * 1000 / us) : 0;
+}
+
+static void bench_frame_ops(UBYTE *image)
+{
+    const UWORD width_byte = WIDTHBYTE(EPD_2IN13_WIDTH);
+    UBYTE *other = (UBYTE *)malloc(IMAGE_SIZE + 1);
+    if (other == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the frame benchmark");
+        return;
+    }
+    memset(other, 0x5A, IMAGE_SIZE + 1);
+
+    ESP_LOGI(TAG, "Frame kernels, KB/s (byte loop / 32-bit):");
+    for (int op = 0; op < 6; op++) {
+        static const char *names[] = {"clear", "invert", "copy", "copy +1", "xor", "popcount"};
+        const UBYTE *src = (op == 3) ? other + 1 : other;
+        volatile UDOUBLE sink = 0;
+
+        int64_t start = esp_timer_get_time();
+        for (int r = 0; r < BENCH_FRAME_ROUNDS; r++) {
+            for (UWORD y = 0; y < EPD_2IN13_HEIGHT; y++) {
+                for (UWORD x = 0; x < width_byte; x++) {
+                    UDOUBLE addr = x + y * width_byte;
+                    switch (op) {
+                    case 0: image[addr] = (UBYTE)r; break;
+                    case 1: image[addr] = ~image[addr]; break;
+                    case 2:
+                    case 3: image[addr] = src[addr]; break;
+                    case 4: image[addr] ^= src[addr]; break;
+                    default: sink += __builtin_popcount(image[addr]); break;
+                    }
+                }
+            }
+        }
+        int64_t byte_us = esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        for (int r = 0; r < BENCH_FRAME_ROUNDS; r++) {
+            switch (op) {
+            case 0: Frame_Fill(image, (UBYTE)r, IMAGE_SIZE); break;
+            case 1: Frame_Invert(image, IMAGE_SIZE); break;
+            case 2:
+            case 3: Frame_Copy(image, src, IMAGE_SIZE); break;
+            case 4: Frame_Xor(image, src, IMAGE_SIZE); break;
+            default: sink += Frame_Popcount(image, IMAGE_SIZE); break;
+            }
+        }
+        int64_t word_us = esp_timer_get_time() - start;
+        (void)sink;
+
+        ESP_LOGI(TAG, "  %-8s: %lu / %lu", names[op],
+                 (unsigned long)bench_frame_rate(byte_us), (unsigned long)bench_frame_rate(word_us));
+    }
+    free(other);
+}
+
+/*
+ * Text and bars on a landscape screen.
+ */
+static void draw_landscape_screen(void)
+{
+    Paint_Clear(WHITE);
+    for (UWORD y = 0; y < 5; y++) {
+        Paint_DrawString_EN(4, 4 + y * 24, "Landscape 0123456789", &Font16, WHITE, BLACK);
+    }
+    for (UWORD x = 0; x < 12; x++) {
+        Paint_DrawRectangle(4 + x * 20, 120 - x * 8, 18 + x * 20, 122, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    }
+}
+
+/*
+ * Draw the same landscape screen into a portrait buffer with ROTATE_90 and
+ * into a landscape buffer, and time the conversion to panel order.
+ */
+static void bench_landscape(UBYTE *image)
+{
+    const UDOUBLE landscape_size = WIDTHBYTE(EPD_2IN13_HEIGHT) * EPD_2IN13_WIDTH;
+    UBYTE *landscape = (UBYTE *)malloc(landscape_size);
+    UBYTE *panel = (UBYTE *)malloc(IMAGE_SIZE);
+    if (landscape == NULL || panel == NULL || EPD_2IN13_SetLayout(EPD_2IN13_LAYOUT_LANDSCAPE) != 0) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the landscape benchmark");
+        free(landscape);
+        free(panel);
+        return;
+    }
+
+    Paint_NewImage(image, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_90, WHITE);
+    Paint_SelectImage(image);
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        draw_landscape_screen();
+    }
+    int64_t rotated_us = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+
+    Paint_NewImage(landscape, EPD_2IN13_HEIGHT, EPD_2IN13_WIDTH, ROTATE_0, WHITE);
+    Paint_SelectImage(landscape);
+    start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        draw_landscape_screen();
+    }
+    int64_t native_us = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+
+    start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_FRAME_ROUNDS; r++) {
+        EPD_2IN13_ToPanel(landscape, panel);
+    }
+    int64_t convert_us = (esp_timer_get_time() - start) / BENCH_FRAME_ROUNDS;
+
+    ESP_LOGI(TAG, "Landscape screen: ROTATE_90 %lld us, landscape buffer %lld us + %lld us transpose (%s)",
+             rotated_us, native_us, convert_us,
+             memcmp(panel, image, IMAGE_SIZE) == 0 ? "identical" : "MISMATCH");
+
+    EPD_2IN13_SetLayout(EPD_2IN13_LAYOUT_PORTRAIT);
+    free(landscape);
+    free(panel);
+    Paint_NewImage(image, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_0, WHITE);
+    Paint_SelectImage(image);
+}
+
+/*
+ * Record the landscape screen in a display list and rasterize it
+ * BENCH_BAND_ROWS panel rows at a time.
+ */
+static void bench_bands(UBYTE *image)
+{
+    PAINT_DLIST list;
+    UBYTE *band = (UBYTE *)malloc(WIDTHBYTE(EPD_2IN13_WIDTH) * BENCH_BAND_ROWS);
+    if (band == NULL || DList_Init(&list, 1024, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_90) != 0) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the band benchmark");
+        free(band);
+        return;
+    }
+
+    DList_Clear(&list, WHITE);
+    for (UWORD y = 0; y < 5; y++) {
+        DList_DrawString(&list, 4, 4 + y * 24, "Landscape 0123456789", &Font16, WHITE, BLACK);
+    }
+    for (UWORD x = 0; x < 12; x++) {
+        DList_DrawRectangle(&list, 4 + x * 20, 120 - x * 8, 18 + x * 20, 122, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    }
+
+    Paint_NewImage(image, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_90, WHITE);
+    Paint_SelectImage(image);
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        draw_landscape_screen();
+    }
+    int64_t frame_us = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+
+    UBYTE same = 1;
+    start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (UWORD y = 0; y < EPD_2IN13_HEIGHT; y += BENCH_BAND_ROWS) {
+            UWORD rows = (EPD_2IN13_HEIGHT - y < BENCH_BAND_ROWS) ? (EPD_2IN13_HEIGHT - y) : BENCH_BAND_ROWS;
+            DList_RenderBand(band, y, rows, &list);
+            if (r == 0 && memcmp(band, &image[y * WIDTHBYTE(EPD_2IN13_WIDTH)], rows * WIDTHBYTE(EPD_2IN13_WIDTH)) != 0) {
+                same = 0;
+            }
+        }
+    }
+    int64_t band_us = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+
+    ESP_LOGI(TAG, "Display list, %d commands in %lu bytes:", list.Count, (unsigned long)list.Used);
+    ESP_LOGI(TAG, "  full frame: %lld us, %d bytes", frame_us, IMAGE_SIZE);
+    ESP_LOGI(TAG, "  %d-row bands: %lld us, %lu bytes (%s)", BENCH_BAND_ROWS, band_us,
+             (unsigned long)(list.Used + WIDTHBYTE(EPD_2IN13_WIDTH) * BENCH_BAND_ROWS),
+             same ? "identical" : "MISMATCH");
+
+    DList_Free(&list);
+    free(band);
+    Paint_NewImage(image, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_0, WHITE);
+    Paint_SelectImage(image);
+}
+
+/*
+ * Record a dashboard heavy enough to keep both cores busy, then rasterize
+ * it on one core and shared out between both.
+ */
+static void bench_parallel(UBYTE *image)
+{
+    PAINT_DLIST list;
+    UBYTE *serial = (UBYTE *)malloc(IMAGE_SIZE);
+    if (serial == NULL || DList_Init(&list, 8192, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_90) != 0) {
+        ESP_LOGE(TAG, "Failed to allocate memory for the parallel benchmark");
+        free(serial);
+        return;
+    }
+
+    DList_Clear(&list, WHITE);
+    for (int i = 0; i < 24; i++) {
+        DList_DrawCircle(&list, (i * 37) % 250, (i * 53) % 122, 10 + i % 16, BLACK, DOT_PIXEL_2X2,
+                         (i & 1) ? DRAW_FILL_FULL : DRAW_FILL_EMPTY);
+        DList_DrawLine(&list, 0, i * 5, 249, 121 - i * 5, BLACK, DOT_PIXEL_3X3, LINE_STYLE_SOLID);
+        DList_DrawString(&list, (i * 29) % 200, (i * 17) % 110, "Dash 42", &Font16, WHITE, BLACK);
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (UWORD y = 0; y < EPD_2IN13_HEIGHT; y += BENCH_BAND_ROWS) {
+            UWORD rows = (EPD_2IN13_HEIGHT - y < BENCH_BAND_ROWS) ? (EPD_2IN13_HEIGHT - y) : BENCH_BAND_ROWS;
+            DList_RenderBand(&serial[y * WIDTHBYTE(EPD_2IN13_WIDTH)], y, rows, &list);
+        }
+    }
+    int64_t serial_us = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+
+    start = esp_timer_get_time();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        DList_RenderParallel(&list, image, BENCH_BAND_ROWS);
+    }
+    int64_t parallel_us = (esp_timer_get_time() - start) / BENCH_ROUNDS;
+
+    ESP_LOGI(TAG, "Dashboard, %d commands in %d-row bands:", list.Count, BENCH_BAND_ROWS);
+    ESP_LOGI(TAG, "  one core  : %lld us", serial_us);
+    ESP_LOGI(TAG, "  %d cores   : %lld us (%s)", portNUM_PROCESSORS, parallel_us,
+             memcmp(serial, image, IMAGE_SIZE) == 0 ? "identical" : "MISMATCH");
+    if (parallel_us > 0) {
+        ESP_LOGI(TAG, "  speedup   : %.2fx", (double)serial_us / parallel_us);
+    }
+
+    DList_Free(&list);
+    free(serial);
+}
+
+void app_main(void)
+{
+    ESP_LOGI(TAG, "=== E-Paper Benchmark ===");
+
+    epd_pin_config_t pin_config = {
+        .rst_pin = GPIO_NUM_4,
+        .dc_pin = GPIO_NUM_9,
+        .cs_pin = GPIO_NUM_10,
+        .busy_pin = GPIO_NUM_18,
+        .clk_pin = GPIO_NUM_6,
+        .mosi_pin = GPIO_NUM_7
+    };
+
+    if (DEV_Module_Init(&pin_config) != 0) {
+        ESP_LOGE(TAG, "Failed to initialize device module");
+        return;
+    }
+
+    UBYTE *image = (UBYTE *)malloc(IMAGE_SIZE);
+    if (image == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for image buffer");
+        DEV_Module_Exit();
+        return;
+    }
+
+    bench_pixel_writers();
+
+    Paint_NewImage(image, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_90, WHITE);
+    Paint_Clear(WHITE);
+    Paint_DrawString_EN(10, 10, "Upload benchmark", &Font16, WHITE, BLACK);
+
+    // Paint: full-screen filled rectangle, per-pixel rows vs span fill
+    int64_t line_us = 0, span_us = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        line_us += bench_fill_per_line(i % 2 ? WHITE : BLACK);
+        span_us += bench_fill_span(i % 2 ? WHITE : BLACK);
+    }
+    ESP_LOGI(TAG, "Full-screen filled rectangle:");
+    ESP_LOGI(TAG, "  per-pixel rows    : %lld us", line_us / BENCH_ROUNDS);
+    ESP_LOGI(TAG, "  span fill         : %lld us", span_us / BENCH_ROUNDS);
+    if (span_us > 0) {
+        ESP_LOGI(TAG, "  speedup           : %.1fx", (double)line_us / span_us);
+    }
+
+    bench_glyphs();
+    bench_circles(image);
+    bench_plot(image);
+    bench_shapes(image);
+    bench_icons();
+    bench_frame_ops(image);
+    bench_landscape(image);
+    bench_bands(image);
+    bench_parallel(image);
+
+    Paint_SetRotate(ROTATE_90);
+    Paint_Clear(WHITE);
+    Paint_DrawString_EN(10, 10, "Upload benchmark", &Font16, WHITE, BLACK);
+
+    EPD_2IN13_Init();
+
+    // Frame upload: legacy per-byte transactions vs bulk DMA
+    int64_t per_byte_us = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        per_byte_us += bench_upload_per_byte(image);
+    }
+    per_byte_us /= BENCH_ROUNDS;
+
+    EPD_2IN13_TIMING timing;
+    EPD_2IN13_Display(image);
+    EPD_2IN13_GetTiming(&timing);
+
+    ESP_LOGI(TAG, "Frame upload (%d bytes):", IMAGE_SIZE);
+    ESP_LOGI(TAG, "  per-byte SendData : %lld us", per_byte_us);
+    ESP_LOGI(TAG, "  bulk DMA          : %lu us", (unsigned long)timing.Upload_us);
+    if (timing.Upload_us > 0) {
+        ESP_LOGI(TAG, "  speedup           : %.1fx", (double)per_byte_us / timing.Upload_us);
+    }
+
+    // Refresh time: OTP partial waveform vs host-loaded LUT profiles
+    static const struct {
+        EPD_2IN13_LUT profile;
+        const char *name;
+    } profiles[] = {
+        {EPD_2IN13_LUT_FULL, "full low-ghost"},
+        {EPD_2IN13_LUT_PARTIAL, "partial"},
+        {EPD_2IN13_LUT_PARTIAL_FAST, "partial fast"},
+    };
+
+    EPD_2IN13_Display_Base(image);
+    Paint_DrawString_EN(10, 40, "OTP", &Font16, WHITE, BLACK);
+    EPD_2IN13_Display_Partial(image);
+    EPD_2IN13_GetTiming(&timing);
+
+    ESP_LOGI(TAG, "Refresh BUSY time:");
+    ESP_LOGI(TAG, "  OTP partial       : %lu ms", (unsigned long)(timing.Busy_us / 1000));
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        Paint_ClearWindows(10, 40, 120, 60, WHITE);
+        Paint_DrawString_EN(10, 40, profiles[i].name, &Font16, WHITE, BLACK);
+        EPD_2IN13_Display_Lut(image, profiles[i].profile);
+        ESP_LOGI(TAG, "  %-18s: %lu ms", profiles[i].name,
+                 (unsigned long)(EPD_2IN13_GetLutBusyTime(profiles[i].profile) / 1000));
+    }
+
+    // 4-gray: 2bpp to two RAM planes, converted while streaming
+    UBYTE *gray = (UBYTE *)malloc(GRAY_IMAGE_SIZE);
+    if (gray != NULL) {
+        Paint_NewImage(gray, EPD_2IN13_WIDTH, EPD_2IN13_HEIGHT, ROTATE_90, WHITE);
+        Paint_SetScale(4);
+        Paint_Clear(WHITE);
+        Paint_DrawRectangle(10, 10, 70, 110, GRAY1, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawRectangle(80, 10, 140, 110, GRAY2, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawRectangle(150, 10, 210, 110, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+
+        EPD_2IN13_Display_4Gray(gray);
+        EPD_2IN13_GetTiming(&timing);
+        ESP_LOGI(TAG, "4-gray frame (%d bytes): split + upload %lu us, BUSY %lu ms", GRAY_IMAGE_SIZE,
+                 (unsigned long)timing.Upload_us, (unsigned long)(timing.Busy_us / 1000));
+        free(gray);
+    }
+
+    EPD_2IN13_Sleep();
+    free(image);
+    DEV_Module_Exit();
+
+    ESP_LOGI(TAG, "Benchmark complete");
+}
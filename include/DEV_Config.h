@@ -45,12 +45,20 @@ extern int EPD_BUSY_PIN;
 extern int EPD_CLK_PIN;
 extern int EPD_MOSI_PIN;
 
+/**
+ * Largest single SPI DMA transaction, one full 2.13" frame (16 x 250 bytes)
+ **/
+#define DEV_SPI_MAX_TRANSFER 4000
+
+#define DEV_WAIT_FOREVER 0xFFFFFFFF
+
 /*------------------------------------------------------------------------------------------------------*/
 void DEV_Digital_Write(UWORD Pin, UBYTE Value);
 UBYTE DEV_Digital_Read(UWORD Pin);
+UBYTE DEV_Busy_Wait(UDOUBLE Timeout_ms);
 
 void DEV_SPI_WriteByte(UBYTE Value);
-void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len);
+void DEV_SPI_Write_nByte(const uint8_t *pData, uint32_t Len);
 void DEV_Delay_ms(UDOUBLE xms);
 
 UBYTE DEV_Module_Init(const epd_pin_config_t *pin_config);
@@ -18,15 +18,121 @@
 #define EPD_2IN13_WIDTH 122
 #define EPD_2IN13_HEIGHT 250
 
-void EPD_2IN13_Init(void);
-void EPD_2IN13_Init_Fast(void);
-void EPD_2IN13_Clear(void);
-void EPD_2IN13_Clear_Black(void);
-void EPD_2IN13_Display(UBYTE *Image);
-void EPD_2IN13_Display_Fast(UBYTE *Image);
-void EPD_2IN13_Display_Base(UBYTE *Image);
-void EPD_2IN13_Display_Partial(UBYTE *Image);
-void EPD_2IN13_Display_PartialRegion(UBYTE *Image, UWORD X, UWORD Y, UWORD Width, UWORD Height);
-void EPD_2IN13_Sleep(void);
+// Controller RAM planes
+#define EPD_2IN13_RAM_BW 0x24
+#define EPD_2IN13_RAM_RED 0x26
+
+/**
+ * Orientation of the picture on the panel, bit values as MIRROR_IMAGE
+ **/
+typedef enum
+{
+    EPD_2IN13_ORIENT_NORMAL = 0x00,
+    EPD_2IN13_ORIENT_MIRROR_X = 0x01,   // Left-right mirror
+    EPD_2IN13_ORIENT_MIRROR_Y = 0x02,   // Top-bottom mirror
+    EPD_2IN13_ORIENT_ROTATE_180 = 0x03, // Both mirrors
+} EPD_2IN13_ORIENTATION;
+
+/**
+ * Layout of the frame buffers passed to the display calls
+ **/
+typedef enum
+{
+    EPD_2IN13_LAYOUT_PORTRAIT = 0, // EPD_2IN13_WIDTH x EPD_2IN13_HEIGHT, panel order
+    EPD_2IN13_LAYOUT_LANDSCAPE,    // EPD_2IN13_HEIGHT x EPD_2IN13_WIDTH, as shown by ROTATE_90
+} EPD_2IN13_LAYOUT;
+
+/**
+ * Timing of the most recent refresh
+ **/
+typedef struct
+{
+    UDOUBLE Upload_us; // Time spent streaming the frame into controller RAM
+    UDOUBLE Busy_us;   // Time the panel held BUSY for the refresh
+} EPD_2IN13_TIMING;
+
+/**
+ * Region in panel coordinates, for batched partial refresh
+ **/
+typedef struct
+{
+    UWORD X;
+    UWORD Y;
+    UWORD Width;
+    UWORD Height;
+} EPD_2IN13_RECT;
+
+// Most windows written in one EPD_2IN13_Display_PartialRegions call
+#define EPD_2IN13_MAX_REGIONS 8
+
+/**
+ * Band-by-band refresh
+ **/
+typedef enum
+{
+    EPD_2IN13_REFRESH_FULL = 0, // As EPD_2IN13_Display
+    EPD_2IN13_REFRESH_FAST,     // As EPD_2IN13_Display_Fast
+    EPD_2IN13_REFRESH_BASE,     // As EPD_2IN13_Display_Base
+    EPD_2IN13_REFRESH_PARTIAL,  // As EPD_2IN13_Display_Partial
+} EPD_2IN13_REFRESH;
+
+// Fills Band with Rows panel rows starting at Ystart, returns 0 on success
+typedef UBYTE (*EPD_2IN13_BAND_FN)(UBYTE *Band, UWORD Ystart, UWORD Rows, void *Ctx);
+
+/**
+ * Host-loaded waveform profiles
+ **/
+typedef enum
+{
+    EPD_2IN13_LUT_FULL = 0,     // Full refresh with low ghosting
+    EPD_2IN13_LUT_PARTIAL,      // Partial refresh
+    EPD_2IN13_LUT_PARTIAL_FAST, // Shortened partial refresh, more ghosting
+    EPD_2IN13_LUT_CUSTOM,       // Table set with EPD_2IN13_SetCustomLut
+    EPD_2IN13_LUT_COUNT
+} EPD_2IN13_LUT;
+
+// 153 waveform bytes, then end option, VGH, VSH1, VSH2, VSL and VCOM
+#define EPD_2IN13_LUT_SIZE 159
+
+/**
+ * Asynchronous refresh
+ **/
+#define EPD_2IN13_WAIT_FOREVER DEV_WAIT_FOREVER
+
+// Default BUSY timeout, a full refresh takes about 2 s at room temperature
+#define EPD_2IN13_BUSY_TIMEOUT_MS 10000
+
+// Status is 0 when the refresh completed, 1 when BUSY timed out or the frame
+// was dropped after a timeout. Runs on the driver task: it may queue another
+// _Async refresh, but synchronous display calls there return 1 at once.
+typedef void (*EPD_2IN13_DONE_CB)(UBYTE Status, void *Ctx);
+
+UBYTE EPD_2IN13_Init(void);
+UBYTE EPD_2IN13_Init_Fast(void);
+UBYTE EPD_2IN13_Clear(void);
+UBYTE EPD_2IN13_Clear_Black(void);
+UBYTE EPD_2IN13_FillRam(UBYTE Ram, UBYTE Value);
+UBYTE EPD_2IN13_Display(UBYTE *Image);
+UBYTE EPD_2IN13_Display_Fast(UBYTE *Image);
+UBYTE EPD_2IN13_Display_Base(UBYTE *Image);
+UBYTE EPD_2IN13_Display_Partial(UBYTE *Image);
+UBYTE EPD_2IN13_Display_PartialRegion(UBYTE *Image, UWORD X, UWORD Y, UWORD Width, UWORD Height);
+UBYTE EPD_2IN13_Display_Bands(UBYTE *Band, UWORD BandRows, EPD_2IN13_BAND_FN Render, void *Ctx, EPD_2IN13_REFRESH Refresh);
+UBYTE EPD_2IN13_Display_PartialRegions(UBYTE *Image, const EPD_2IN13_RECT *Rects, UWORD Count);
+UBYTE EPD_2IN13_SetAutoPartial(UBYTE Enable);
+UBYTE EPD_2IN13_Display_PartialAuto(UBYTE *Image);
+UBYTE EPD_2IN13_SetCustomLut(const UBYTE *Lut, UBYTE Partial);
+UBYTE EPD_2IN13_Display_Lut(UBYTE *Image, EPD_2IN13_LUT Profile);
+UDOUBLE EPD_2IN13_GetLutBusyTime(EPD_2IN13_LUT Profile);
+UBYTE EPD_2IN13_Display_4Gray(UBYTE *Image);
+UBYTE EPD_2IN13_Sleep(void);
+UBYTE EPD_2IN13_Display_Async(UBYTE *Image, EPD_2IN13_DONE_CB Cb, void *Ctx);
+UBYTE EPD_2IN13_Display_Partial_Async(UBYTE *Image, EPD_2IN13_DONE_CB Cb, void *Ctx);
+UBYTE EPD_2IN13_WaitIdle(UDOUBLE Timeout_ms);
+void EPD_2IN13_SetBusyTimeout(UDOUBLE Timeout_ms);
+void EPD_2IN13_GetTiming(EPD_2IN13_TIMING *Timing);
+UBYTE EPD_2IN13_SetOrientation(EPD_2IN13_ORIENTATION Orientation);
+UBYTE EPD_2IN13_SetLayout(EPD_2IN13_LAYOUT Layout);
+void EPD_2IN13_ToPanel(const UBYTE *Image, UBYTE *Panel);
 
 #endif
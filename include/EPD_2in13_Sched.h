@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * | File      	:   EPD_2in13_Sched.h
+ * | Author      :
+ * | Function    :   Ghosting-aware refresh scheduler for the 2.13inch e-paper
+ * | Info        :
+ *----------------
+ * |	This version:   V1.0
+ * | Date        :
+ * | Info        :
+ * -----------------------------------------------------------------------------
+ ******************************************************************************/
+#ifndef __EPD_2IN13_SCHED_H_
+#define __EPD_2IN13_SCHED_H_
+
+#include "EPD_2in13.h"
+
+// The panel is tracked in 32x32 pixel tiles
+#define EPD_2IN13_SCHED_TILE 32
+#define EPD_2IN13_SCHED_TILES_X ((EPD_2IN13_WIDTH + EPD_2IN13_SCHED_TILE - 1) / EPD_2IN13_SCHED_TILE)
+#define EPD_2IN13_SCHED_TILES_Y ((EPD_2IN13_HEIGHT + EPD_2IN13_SCHED_TILE - 1) / EPD_2IN13_SCHED_TILE)
+#define EPD_2IN13_SCHED_TILES (EPD_2IN13_SCHED_TILES_X * EPD_2IN13_SCHED_TILES_Y)
+
+// Partial refreshes use the OTP waveform instead of a LUT profile
+#define EPD_2IN13_SCHED_OTP EPD_2IN13_LUT_COUNT
+
+/**
+ * Refresh run when the ghosting budget is used up
+ **/
+typedef enum
+{
+    EPD_2IN13_SCHED_CLEAN_FULL = 0, // OTP full refresh, EPD_2IN13_Display_Base
+    EPD_2IN13_SCHED_CLEAN_FAST,     // Host-loaded EPD_2IN13_LUT_FULL waveform
+} EPD_2IN13_SCHED_CLEAN;
+
+/**
+ * Ghosting budget, a limit of 0 disables that check
+ **/
+typedef struct
+{
+    UWORD MaxTilePartials;        // Partial refreshes any one tile may take
+    UDOUBLE MaxChangedPixels;     // Changed pixels summed over all partial refreshes
+    UDOUBLE MaxInterval_ms;       // Time since the last clean-up refresh
+    EPD_2IN13_SCHED_CLEAN Clean;  // Clean-up refresh to run
+    EPD_2IN13_LUT PartialProfile; // EPD_2IN13_LUT_PARTIAL* or EPD_2IN13_SCHED_OTP
+} EPD_2IN13_SCHED_CONFIG;
+
+#define EPD_2IN13_SCHED_CONFIG_DEFAULT {              \
+    .MaxTilePartials = 20,                            \
+    .MaxChangedPixels = 4 * EPD_2IN13_WIDTH * EPD_2IN13_HEIGHT, \
+    .MaxInterval_ms = 60 * 60 * 1000,                 \
+    .Clean = EPD_2IN13_SCHED_CLEAN_FULL,              \
+    .PartialProfile = EPD_2IN13_SCHED_OTP,            \
+}
+
+/**
+ * Why a clean-up refresh was run
+ **/
+typedef enum
+{
+    EPD_2IN13_SCHED_REASON_NONE = 0, // No clean-up yet
+    EPD_2IN13_SCHED_REASON_FIRST,    // First frame, controller RAM unknown
+    EPD_2IN13_SCHED_REASON_TILE,     // A tile reached MaxTilePartials
+    EPD_2IN13_SCHED_REASON_AREA,     // MaxChangedPixels reached
+    EPD_2IN13_SCHED_REASON_TIME,     // MaxInterval_ms elapsed
+    EPD_2IN13_SCHED_REASON_FORCED,   // EPD_2IN13_Sched_Clean
+} EPD_2IN13_SCHED_REASON;
+
+/**
+ * Scheduler counters
+ **/
+typedef struct
+{
+    UDOUBLE Partials;      // Partial refreshes completed
+    UDOUBLE Cleans;        // Clean-up refreshes completed
+    UDOUBLE Skipped;       // Frames identical to the previous one
+    UDOUBLE CleansByTile;  // Clean-ups caused by MaxTilePartials
+    UDOUBLE CleansByArea;  // Clean-ups caused by MaxChangedPixels
+    UDOUBLE CleansByTime;  // Clean-ups caused by MaxInterval_ms
+    EPD_2IN13_SCHED_REASON LastReason;
+
+    // Budget used since the last clean-up
+    UDOUBLE ChangedPixels;
+    UDOUBLE SinceClean_ms;
+    UWORD MaxTilePartials;
+    UWORD TilePartials[EPD_2IN13_SCHED_TILES]; // Row-major, EPD_2IN13_SCHED_TILES_X per row
+} EPD_2IN13_SCHED_STATS;
+
+UBYTE EPD_2IN13_Sched_Init(const EPD_2IN13_SCHED_CONFIG *Config);
+void EPD_2IN13_Sched_Exit(void);
+UBYTE EPD_2IN13_Sched_Display(UBYTE *Image);
+UBYTE EPD_2IN13_Sched_Clean(UBYTE *Image);
+void EPD_2IN13_Sched_GetStats(EPD_2IN13_SCHED_STATS *Stats);
+void EPD_2IN13_Sched_ResetStats(void);
+
+#endif
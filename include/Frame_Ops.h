@@ -0,0 +1,55 @@
+/*****************************************************************************
+ * | File      	:   Frame_Ops.h
+ * | Author      :
+ * | Function    :   Word-at-a-time kernels for 1bpp frame buffers
+ * | Info        :
+ *----------------
+ * |	This version:   V1.0
+ * | Date        :
+ * | Info        :
+ * -----------------------------------------------------------------------------
+ ******************************************************************************/
+#ifndef __FRAME_OPS_H_
+#define __FRAME_OPS_H_
+
+#include "DEV_Config.h"
+
+/******************************************************************************
+function :	Count the set bits of a word
+parameter:
+    x : Word
+Info:
+    SWAR sum, the core has no population count instruction.
+******************************************************************************/
+static inline UDOUBLE Frame_Popcount32(uint32_t x)
+{
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    x = (x + (x >> 4)) & 0x0F0F0F0F;
+    return (x * 0x01010101) >> 24;
+}
+
+/******************************************************************************
+function :	Transpose an 8x8 bit matrix
+parameter:
+    x : Row r in byte 7 - r, column c in bit 7 - c of that byte
+******************************************************************************/
+static inline uint64_t Frame_Transpose8x8(uint64_t x)
+{
+    x = (x & 0xAA55AA55AA55AA55ULL) | ((x & 0x00AA00AA00AA00AAULL) << 7) | ((x >> 7) & 0x00AA00AA00AA00AAULL);
+    x = (x & 0xCCCC3333CCCC3333ULL) | ((x & 0x0000CCCC0000CCCCULL) << 14) | ((x >> 14) & 0x0000CCCC0000CCCCULL);
+    x = (x & 0xF0F0F0F00F0F0F0FULL) | ((x & 0x00000000F0F0F0F0ULL) << 28) | ((x >> 28) & 0x00000000F0F0F0F0ULL);
+    return x;
+}
+
+// Whole buffers, any alignment and length
+void Frame_Fill(UBYTE *Dst, UBYTE Value, UDOUBLE Len);
+void Frame_Invert(UBYTE *Dst, UDOUBLE Len);
+void Frame_Copy(UBYTE *Dst, const UBYTE *Src, UDOUBLE Len);
+void Frame_Xor(UBYTE *Dst, const UBYTE *Src, UDOUBLE Len);
+void Frame_Or(UBYTE *Dst, const UBYTE *Src, UDOUBLE Len);
+UDOUBLE Frame_Popcount(const UBYTE *Src, UDOUBLE Len);
+UDOUBLE Frame_DiffCount(const UBYTE *A, const UBYTE *B, UDOUBLE Len);
+UBYTE Frame_DiffRange(const UBYTE *A, const UBYTE *B, UDOUBLE Len, UDOUBLE *First, UDOUBLE *Last);
+
+#endif
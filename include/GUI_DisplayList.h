@@ -0,0 +1,73 @@
+/*****************************************************************************
+ * | File      	:   GUI_DisplayList.h
+ * | Author      :
+ * | Function    :   Record Paint calls and replay them band by band
+ * | Info        :
+ *   A display list keeps the drawing calls of one frame instead of the
+ *   pixels, so the frame can be rasterized a few rows at a time into a
+ *   small band buffer.
+ *----------------
+ * |	This version:   V1.0
+ * | Date        :
+ * | Info        :
+ * -----------------------------------------------------------------------------
+ ******************************************************************************/
+#ifndef __GUI_DISPLAYLIST_H_
+#define __GUI_DISPLAYLIST_H_
+
+#include "DEV_Config.h"
+#include "GUI_Paint.h"
+
+/**
+ * Recorded frame
+ **/
+typedef struct
+{
+    UBYTE *Buffer;  // Commands, allocated by DList_Init
+    UDOUBLE Size;   // Bytes in Buffer
+    UDOUBLE Used;   // Bytes recorded
+    UWORD Count;    // Commands recorded
+    UBYTE Overflow; // A command did not fit and was dropped
+    UWORD Width;    // Image size and rotation, as for Paint_NewImage
+    UWORD Height;
+    UWORD Rotate;
+} PAINT_DLIST;
+
+// Bytes of a band of Rows rows of a PAINT_DLIST image
+#define DLIST_BAND_BYTES(List, Rows) ((UDOUBLE)(((List)->Width + 7) / 8) * (Rows))
+
+UBYTE DList_Init(PAINT_DLIST *List, UDOUBLE Size, UWORD Width, UWORD Height, UWORD Rotate);
+void DList_Free(PAINT_DLIST *List);
+void DList_Reset(PAINT_DLIST *List);
+
+// Rasterize memory rows Ystart to Ystart + Rows - 1, Ctx is the PAINT_DLIST
+UBYTE DList_RenderBand(UBYTE *Band, UWORD Ystart, UWORD Rows, void *Ctx);
+// Rasterize the whole frame into Image, bands shared out between both cores
+UBYTE DList_RenderParallel(const PAINT_DLIST *List, UBYTE *Image, UWORD BandRows);
+
+// Recording, same arguments as the Paint calls with signed coordinates.
+// Fonts, bitmaps and Paint_Blit sources are kept by pointer and must stay
+// valid until the list is rendered; strings and points are copied.
+UBYTE DList_Clear(PAINT_DLIST *List, UWORD Color);
+UBYTE DList_ClearWindows(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color);
+UBYTE DList_PushClip(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend);
+UBYTE DList_PopClip(PAINT_DLIST *List);
+UBYTE DList_SetPixel(PAINT_DLIST *List, int Xpoint, int Ypoint, UWORD Color);
+UBYTE DList_DrawPoint(PAINT_DLIST *List, int Xpoint, int Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
+UBYTE DList_DrawLine(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+UBYTE DList_DrawLineCap(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap);
+UBYTE DList_DrawRectangle(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+UBYTE DList_DrawCircle(PAINT_DLIST *List, int X_Center, int Y_Center, int Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+UBYTE DList_DrawEllipse(PAINT_DLIST *List, int X_Center, int Y_Center, int X_Radius, int Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+UBYTE DList_DrawRoundRect(PAINT_DLIST *List, int Xstart, int Ystart, int Xend, int Yend, int Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+UBYTE DList_DrawArc(PAINT_DLIST *List, int X_Center, int Y_Center, int Radius, int Start_Angle, int End_Angle, UWORD Color, DOT_PIXEL Line_width);
+UBYTE DList_FillTriangle(PAINT_DLIST *List, int X0, int Y0, int X1, int Y1, int X2, int Y2, UWORD Color);
+UBYTE DList_DrawPolygon(PAINT_DLIST *List, const PAINT_POINT *Points, UWORD Count, UWORD Color, DOT_PIXEL Line_width);
+UBYTE DList_FillPolygon(PAINT_DLIST *List, const PAINT_POINT *Points, UWORD Count, UWORD Color);
+UBYTE DList_DrawChar(PAINT_DLIST *List, int Xpoint, int Ypoint, const char Acsii_Char, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+UBYTE DList_DrawString(PAINT_DLIST *List, int Xstart, int Ystart, const char *pString, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+UBYTE DList_DrawNum(PAINT_DLIST *List, UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+UBYTE DList_DrawBitMap(PAINT_DLIST *List, const unsigned char *image_buffer);
+UBYTE DList_Blit(PAINT_DLIST *List, int Xpoint, int Ypoint, UWORD Width, UWORD Height, const UBYTE *Src, UWORD Stride, PAINT_ROP Rop);
+
+#endif
@@ -18,12 +18,28 @@
 #include "DEV_Config.h"
 #include "fonts.h"
 
+struct PAINT_S;
+typedef void (*PAINT_WRITER_FN)(const struct PAINT_S *P, UWORD Xpoint, UWORD Ypoint, UWORD Color);
+
 /**
- * Image attributes
+ * Clip rectangle in drawing coordinates, Xend and Yend exclusive
  **/
 typedef struct
+{
+    UWORD Xstart;
+    UWORD Ystart;
+    UWORD Xend;
+    UWORD Yend;
+} PAINT_CLIP;
+#define PAINT_CLIP_DEPTH 8 // Nested Paint_PushClip calls
+
+/**
+ * Image attributes
+ **/
+typedef struct PAINT_S
 {
     UBYTE *Image;
+    UWORD ImageRow; // Memory row stored at Image[0], nonzero after Paint_SelectBand
     UWORD Width;
     UWORD Height;
     UWORD WidthMemory;
@@ -34,8 +50,12 @@ typedef struct
     UWORD WidthByte;
     UWORD HeightByte;
     UWORD Scale;
+    PAINT_WRITER_FN Writer; // Pixel writer for Rotate, Mirror and Scale, set by the Paint_Set* calls
+    PAINT_CLIP Clip;        // Every drawing call is limited to this rectangle
+    PAINT_CLIP ClipStack[PAINT_CLIP_DEPTH];
+    UBYTE ClipDepth;
 } PAINT;
-extern PAINT Paint;
+extern PAINT Paint; // Context of the calls without _Ctx
 
 /**
  * Display rotate
@@ -63,6 +83,9 @@ typedef enum
 #define WHITE 0xFF
 #define BLACK 0x00
 #define RED BLACK
+// Scale 4 only, between WHITE (0x03) and BLACK (0x00)
+#define GRAY1 0x02 // Light gray
+#define GRAY2 0x01 // Dark gray
 
 #define IMAGE_BACKGROUND WHITE
 #define FONT_FOREGROUND BLACK
@@ -103,6 +126,16 @@ typedef enum
     LINE_STYLE_DOTTED,
 } LINE_STYLE;
 
+/**
+ * Line end caps, for lines wider than one pixel
+ **/
+typedef enum
+{
+    LINE_CAP_SQUARE = 0, // Reaches Line_width - 1 past the end points, as Paint_DrawLine does
+    LINE_CAP_BUTT,       // Stops at the end points
+    LINE_CAP_ROUND,      // Half disc around the end points
+} LINE_CAP;
+
 /**
  * Whether the graphic is filled
  **/
@@ -112,6 +145,28 @@ typedef enum
     DRAW_FILL_FULL,
 } DRAW_FILL;
 
+/**
+ * Raster operation of Paint_Blit, on the stored bits where 1 is white
+ **/
+typedef enum
+{
+    PAINT_ROP_COPY = 0, // Replace the pixels
+    PAINT_ROP_OR,       // Draw the white bitmap pixels only
+    PAINT_ROP_AND,      // Draw the black bitmap pixels only
+    PAINT_ROP_XOR,      // Invert where the bitmap is white
+    PAINT_ROP_MASK,     // Copy where the mask stored after the bitmap is 1
+} PAINT_ROP;
+
+/**
+ * Polygon vertex
+ **/
+typedef struct
+{
+    int X;
+    int Y;
+} PAINT_POINT;
+#define PAINT_POLY_STACK_POINTS 16 // Paint_FillPolygon vertices filled without a heap allocation
+
 /**
  * Custom structure of a time attribute
  **/
@@ -129,25 +184,101 @@ extern PAINT_TIME sPaint_time;
 // init and Clear
 void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color);
 void Paint_SelectImage(UBYTE *image);
+void Paint_SelectBand(UBYTE *Band, UWORD Ystart, UWORD Rows);
 void Paint_SetRotate(UWORD Rotate);
 void Paint_SetMirroring(UBYTE mirror);
 void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color);
 void Paint_SetScale(UBYTE scale);
 
+// Clipping, coordinates may lie outside the image
+UBYTE Paint_PushClip(int Xstart, int Ystart, int Xend, int Yend);
+UBYTE Paint_PopClip(void);
+void Paint_ResetClip(void);
+
 void Paint_Clear(UWORD Color);
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
 
 // Drawing
 void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
 void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void Paint_DrawLineCap(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap);
 void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
 void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawEllipse(UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
+// Bitmaps, 1bpp images only for Paint_Blit
+void Paint_DrawBitMap(const unsigned char *image_buffer);
+void Paint_Blit(int Xpoint, int Ypoint, UWORD Width, UWORD Height, const UBYTE *Src, UWORD Stride, PAINT_ROP Rop);
 
 // Display string
 void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char *pString, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
 void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_SetGlyphCache(UBYTE Enable);
 void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+
+// Signed coordinates: anything outside the clip rectangle is skipped silently
+void Paint_SetPixel_S(int Xpoint, int Ypoint, UWORD Color);
+void Paint_ClearWindows_S(int Xstart, int Ystart, int Xend, int Yend, UWORD Color);
+void Paint_DrawPoint_S(int Xpoint, int Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
+void Paint_DrawLine_S(int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void Paint_DrawLineCap_S(int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap);
+void Paint_DrawRectangle_S(int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawCircle_S(int X_Center, int Y_Center, int Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawEllipse_S(int X_Center, int Y_Center, int X_Radius, int Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawChar_S(int Xpoint, int Ypoint, const char Acsii_Char, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawString_S(int Xstart, int Ystart, const char *pString, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+
+// Polygons and rounded shapes, signed coordinates, filled as spans
+void Paint_DrawPolygon(const PAINT_POINT *Points, UWORD Count, UWORD Color, DOT_PIXEL Line_width);
+void Paint_FillPolygon(const PAINT_POINT *Points, UWORD Count, UWORD Color);
+void Paint_FillTriangle(int X0, int Y0, int X1, int Y1, int X2, int Y2, UWORD Color);
+void Paint_DrawRoundRect(int Xstart, int Ystart, int Xend, int Yend, int Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawArc(int X_Center, int Y_Center, int Radius, int Start_Angle, int End_Angle, UWORD Color, DOT_PIXEL Line_width);
+
+// Every call above on an explicit context instead of the global Paint.
+// Contexts share nothing but the rotated glyph cache, so tasks on different
+// cores can draw into their own buffers at the same time.
+void Paint_NewImage_Ctx(PAINT *P, UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color);
+void Paint_SelectImage_Ctx(PAINT *P, UBYTE *image);
+void Paint_SelectBand_Ctx(PAINT *P, UBYTE *Band, UWORD Ystart, UWORD Rows);
+void Paint_SetRotate_Ctx(PAINT *P, UWORD Rotate);
+void Paint_SetMirroring_Ctx(PAINT *P, UBYTE mirror);
+void Paint_SetPixel_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, UWORD Color);
+void Paint_SetScale_Ctx(PAINT *P, UBYTE scale);
+UBYTE Paint_PushClip_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend);
+UBYTE Paint_PopClip_Ctx(PAINT *P);
+void Paint_ResetClip_Ctx(PAINT *P);
+void Paint_Clear_Ctx(PAINT *P, UWORD Color);
+void Paint_ClearWindows_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
+void Paint_DrawPoint_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
+void Paint_DrawLine_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void Paint_DrawLineCap_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap);
+void Paint_DrawRectangle_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawCircle_Ctx(PAINT *P, UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawEllipse_Ctx(PAINT *P, UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawBitMap_Ctx(PAINT *P, const unsigned char *image_buffer);
+void Paint_Blit_Ctx(PAINT *P, int Xpoint, int Ypoint, UWORD Width, UWORD Height, const UBYTE *Src, UWORD Stride, PAINT_ROP Rop);
+void Paint_DrawChar_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawString_EN_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, const char *pString, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawNum_Ctx(PAINT *P, UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawTime_Ctx(PAINT *P, UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_SetPixel_S_Ctx(PAINT *P, int Xpoint, int Ypoint, UWORD Color);
+void Paint_ClearWindows_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, UWORD Color);
+void Paint_DrawPoint_S_Ctx(PAINT *P, int Xpoint, int Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
+void Paint_DrawLine_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void Paint_DrawLineCap_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, LINE_CAP Line_Cap);
+void Paint_DrawRectangle_S_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawCircle_S_Ctx(PAINT *P, int X_Center, int Y_Center, int Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawEllipse_S_Ctx(PAINT *P, int X_Center, int Y_Center, int X_Radius, int Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawChar_S_Ctx(PAINT *P, int Xpoint, int Ypoint, const char Acsii_Char, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawString_S_Ctx(PAINT *P, int Xstart, int Ystart, const char *pString, sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_DrawPolygon_Ctx(PAINT *P, const PAINT_POINT *Points, UWORD Count, UWORD Color, DOT_PIXEL Line_width);
+void Paint_FillPolygon_Ctx(PAINT *P, const PAINT_POINT *Points, UWORD Count, UWORD Color);
+void Paint_FillTriangle_Ctx(PAINT *P, int X0, int Y0, int X1, int Y1, int X2, int Y2, UWORD Color);
+void Paint_DrawRoundRect_Ctx(PAINT *P, int Xstart, int Ystart, int Xend, int Yend, int Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_DrawArc_Ctx(PAINT *P, int X_Center, int Y_Center, int Radius, int Start_Angle, int End_Angle, UWORD Color, DOT_PIXEL Line_width);
+
 // Chinese fonts not supported - cFONT type not defined
 // void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background);
 